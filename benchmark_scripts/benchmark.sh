@@ -21,9 +21,8 @@ for NUM_CYCLES in "${CYCLE_COUNT[@]}"; do
         start_time=$(date +%s.%N)
         echo "running $TYPE: dfs"
         mkdir -p output/$TYPE
-        cat input/$TYPE.txt | 
-            sed "s|^|$DATA_DIR/|" |
-            parallel --jobs $THREADS "./bin/dpt_planarizer {} $NUM_CYCLES $RERUNS" > output/$TYPE/dfs_${NUM_CYCLES}.csv
+        # one process solves the whole list, see the batch mode of dpt_planarizer
+        ./bin/dpt_planarizer -b -j $THREADS -d $DATA_DIR input/$TYPE.txt $NUM_CYCLES $RERUNS > output/$TYPE/dfs_${NUM_CYCLES}.csv
         end_time=$(date +%s.%N)
         elapsed_time=$(echo "$end_time - $start_time" | bc)
         echo "Elapsed time: $elapsed_time seconds"
@@ -0,0 +1,38 @@
+#!/bin/bash
+
+# Scaling run on graphs with deep DFS trees, up to 10M vertices.
+# The solver must finish every size under the default 8 MB stack.
+# Every vertex of these graphs has at least three neighbors, so the reduction
+# removes nothing and the times measure the search on the whole graph.
+
+MAKE_DEEP_GRAPH=../make_graphs/bin/make_deep_graph
+
+NODE_COUNT=(10000 100000 1000000 10000000)
+
+LONG_CHORDS=20
+
+NUM_CYCLES=10
+
+RERUNS=1
+
+mkdir -p output/scaling
+mkdir -p scaling_graphs
+
+ulimit -s 8192
+
+for NODES in "${NODE_COUNT[@]}"; do
+    echo "running deep graph with $NODES nodes"
+    $MAKE_DEEP_GRAPH $NODES $LONG_CHORDS 1 1 scaling_graphs
+    start_time=$(date +%s.%N)
+    ./bin/dpt_planarizer scaling_graphs/deepn${NODES}c${LONG_CHORDS}s1i0.gml $NUM_CYCLES $RERUNS >> output/scaling/dfs_${NUM_CYCLES}.csv
+    if [ $? -ne 0 ]; then
+        echo "failed on $NODES nodes"
+        exit 1
+    fi
+    end_time=$(date +%s.%N)
+    elapsed_time=$(echo "$end_time - $start_time" | bc)
+    echo "Elapsed time: $elapsed_time seconds"
+    echo ""
+done
+
+echo "scaling finished"
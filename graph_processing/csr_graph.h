@@ -0,0 +1,209 @@
+/*  Binary CSR graph format, shared by the converter, the solver and the heuristics
+ *
+ *  A file is a 64 byte header followed by three arrays, each starting on an 8 byte boundary:
+ *      uint32 offsets[node_num + 1]        row i is targets[offsets[i]] ... targets[offsets[i+1]-1]
+ *      uint32 targets[2 * edge_num]        every edge is listed in the rows of both end points,
+ *                                          a self-loop twice in its own row
+ *      int64  original_ids[node_num]       only with CSR_HAS_ORIGINAL_IDS: the id of node i in
+ *                                          the file it was converted from
+ *  Rows hold the neighbors in the order of the source file's edges, so a graph read back from
+ *  a row is the graph the solver would build from the source file.
+ *  All values are little-endian; a file is mapped read-only and used in place.
+ */
+#ifndef _CSR_GRAPH_H
+#define _CSR_GRAPH_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+const char CSR_MAGIC[8] = {'M', 'P', 'S', 'C', 'S', 'R', '\0', '\0'};
+const uint32_t CSR_VERSION = 1;
+const uint32_t CSR_HAS_ORIGINAL_IDS = 1;
+
+struct csr_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t node_num;
+    uint64_t edge_num;
+    uint64_t reserved[4];
+};
+
+inline uint64_t csr_align(uint64_t bytes) {return (bytes + 7) & ~static_cast<uint64_t>(7);}
+
+inline bool is_csr_file(const std::string &file) {
+    FILE *f = fopen(file.c_str(), "rb");
+    if (f == nullptr) return false;
+    char magic[8];
+    bool is_csr = fread(magic, 1, 8, f) == 8 && memcmp(magic, CSR_MAGIC, 8) == 0;
+    fclose(f);
+    return is_csr;
+}
+
+// write the graph with node_num nodes and the given edges, original_ids may be empty
+inline bool write_csr_graph(const std::string &file, uint64_t node_num,
+                            const std::vector<std::pair<int, int> > &edges,
+                            const std::vector<int64_t> &original_ids) {
+    if (2 * static_cast<uint64_t>(edges.size()) > UINT32_MAX) return false;
+    std::vector<uint32_t> offsets(node_num + 1, 0);
+    for (const std::pair<int, int> &e : edges) {
+        offsets[e.first + 1]++;
+        offsets[e.second + 1]++;
+    }
+    for (uint64_t i = 0; i < node_num; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+    std::vector<uint32_t> targets(offsets[node_num]);
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (const std::pair<int, int> &e : edges) {
+        targets[fill[e.first]++] = e.second;
+        targets[fill[e.second]++] = e.first;
+    }
+
+    csr_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CSR_MAGIC, 8);
+    header.version = CSR_VERSION;
+    header.flags = original_ids.empty() ? 0 : CSR_HAS_ORIGINAL_IDS;
+    header.node_num = node_num;
+    header.edge_num = edges.size();
+
+    FILE *f = fopen(file.c_str(), "wb");
+    if (f == nullptr) return false;
+    const char padding[8] = {0};
+    uint64_t offsets_bytes = offsets.size() * sizeof(uint32_t);
+    uint64_t targets_bytes = targets.size() * sizeof(uint32_t);
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+    ok = ok && fwrite(offsets.data(), 1, offsets_bytes, f) == offsets_bytes;
+    ok = ok && fwrite(padding, 1, csr_align(offsets_bytes) - offsets_bytes, f) == csr_align(offsets_bytes) - offsets_bytes;
+    ok = ok && fwrite(targets.data(), 1, targets_bytes, f) == targets_bytes;
+    ok = ok && fwrite(padding, 1, csr_align(targets_bytes) - targets_bytes, f) == csr_align(targets_bytes) - targets_bytes;
+    if (!original_ids.empty()) {
+        ok = ok && fwrite(original_ids.data(), sizeof(int64_t), node_num, f) == node_num;
+    }
+    return fclose(f) == 0 && ok;
+}
+
+// a mapped CSR file, the arrays point into the mapping and live as long as the object
+class csr_graph_file {
+public:
+    csr_graph_file() {}
+    ~csr_graph_file() {close();}
+    csr_graph_file(const csr_graph_file &) = delete;
+    csr_graph_file &operator=(const csr_graph_file &) = delete;
+
+    // map the file and check that the header, the array sizes and the rows agree with it
+    bool open(const std::string &file) {
+        close();
+        int fd = ::open(file.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 || static_cast<uint64_t>(file_stat.st_size) < sizeof(csr_header)) {
+            ::close(fd);
+            return false;
+        }
+        _size = file_stat.st_size;
+        _data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (_data == MAP_FAILED) {
+            _data = nullptr;
+            return false;
+        }
+        const char *base = static_cast<const char*>(_data);
+        const csr_header *header = reinterpret_cast<const csr_header*>(base);
+        if (memcmp(header->magic, CSR_MAGIC, 8) != 0 || header->version != CSR_VERSION) {
+            close();
+            return false;
+        }
+        // node ids are ints and the targets of all rows are counted by uint32 offsets, which also
+        // keeps the sizes below from overflowing
+        if (header->node_num > INT_MAX || header->edge_num > UINT32_MAX / 2) {
+            close();
+            return false;
+        }
+        _node_num = header->node_num;
+        _edge_num = header->edge_num;
+        uint64_t offsets_at = sizeof(csr_header);
+        uint64_t targets_at = offsets_at + csr_align((_node_num + 1) * sizeof(uint32_t));
+        uint64_t ids_at = targets_at + csr_align(2 * _edge_num * sizeof(uint32_t));
+        uint64_t end = ids_at + ((header->flags & CSR_HAS_ORIGINAL_IDS) ? _node_num * sizeof(int64_t) : 0);
+        if (end > _size) {
+            close();
+            return false;
+        }
+        _offsets = reinterpret_cast<const uint32_t*>(base + offsets_at);
+        _targets = reinterpret_cast<const uint32_t*>(base + targets_at);
+        _original_ids = (header->flags & CSR_HAS_ORIGINAL_IDS) ? reinterpret_cast<const int64_t*>(base + ids_at) : nullptr;
+        if (!valid_rows()) {
+            close();
+            return false;
+        }
+        madvise(_data, _size, MADV_WILLNEED);
+        return true;
+    }
+
+    void close() {
+        if (_data != nullptr) munmap(_data, _size);
+        _data = nullptr;
+        _size = 0;
+        _node_num = _edge_num = 0;
+        _offsets = _targets = nullptr;
+        _original_ids = nullptr;
+    }
+
+    uint64_t node_num() const {return _node_num;}
+    uint64_t edge_num() const {return _edge_num;}
+    const uint32_t *offsets() const {return _offsets;}
+    const uint32_t *targets() const {return _targets;}
+    const int64_t *original_ids() const {return _original_ids;} // nullptr if the file has none
+
+    // call f(u, v) once per edge, with u <= v, in row order
+    template <class callback>
+    void for_each_edge(callback f) const {
+        for (uint64_t u = 0; u < _node_num; ++u) {
+            bool loop_seen = false;
+            for (uint32_t k = _offsets[u]; k < _offsets[u + 1]; ++k) {
+                uint32_t v = _targets[k];
+                if (v > u) f(static_cast<int>(u), static_cast<int>(v));
+                else if (v == u) {
+                    // a self-loop is listed twice
+                    if (!loop_seen) f(static_cast<int>(u), static_cast<int>(v));
+                    loop_seen = !loop_seen;
+                }
+            }
+        }
+    }
+
+private:
+    // the rows must tile the targets in order and every target must be a node, otherwise a
+    // corrupt file would be read out of bounds
+    bool valid_rows() const {
+        if (_offsets[0] != 0 || _offsets[_node_num] != 2 * _edge_num) return false;
+        for (uint64_t u = 0; u < _node_num; ++u) {
+            if (_offsets[u] > _offsets[u + 1]) return false;
+        }
+        for (uint64_t k = 0; k < 2 * _edge_num; ++k) {
+            if (_targets[k] >= _node_num) return false;
+        }
+        return true;
+    }
+
+    void *_data = nullptr;
+    uint64_t _size = 0;
+    uint64_t _node_num = 0;
+    uint64_t _edge_num = 0;
+    const uint32_t *_offsets = nullptr;
+    const uint32_t *_targets = nullptr;
+    const int64_t *_original_ids = nullptr;
+};
+
+#endif
@@ -0,0 +1,34 @@
+/*  Reading a graph for the ogdf programs, from gml or from the CSR format of csr_graph.h
+ *
+ *  A CSR file is mapped and its rows are turned into the nodes and edges of G directly, which
+ *  skips parsing the text; G still owns its own copy, ogdf has no view over foreign arrays.
+ *  Node i of G is node i of the file and edges are created in row order.
+ */
+#ifndef _CSR_OGDF_H
+#define _CSR_OGDF_H
+
+#include "csr_graph.h"
+#include <ogdf/fileformats/GraphIO.h>
+
+#include <string>
+#include <vector>
+
+inline bool read_csr_graph(ogdf::Graph &G, const std::string &input_file) {
+    csr_graph_file csr;
+    if (!csr.open(input_file)) return false;
+    G.clear();
+    std::vector<ogdf::node> nodes(csr.node_num());
+    for (uint64_t i = 0; i < csr.node_num(); ++i) {
+        nodes[i] = G.newNode();
+    }
+    csr.for_each_edge([&](int u, int v) { G.newEdge(nodes[u], nodes[v]); });
+    return true;
+}
+
+// read input_file into G: a CSR file by its rows, anything else as gml
+inline bool read_graph(ogdf::Graph &G, const std::string &input_file) {
+    if (is_csr_file(input_file)) return read_csr_graph(G, input_file);
+    return ogdf::GraphIO::read(G, input_file, ogdf::GraphIO::readGML);
+}
+
+#endif
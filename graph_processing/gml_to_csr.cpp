@@ -0,0 +1,46 @@
+/* This code converts gml to the binary CSR format of csr_graph.h
+ * the gml file is read with the solver's reader, so node i of the CSR file is node i of the solver
+ * the node ids of the gml file are kept, unless -n is given
+ *
+ * build: g++ -std=c++17 -O2 -DMPS_NO_OGDF gml_to_csr.cpp ../guided_mutation/src/gml_reader.cpp -I../guided_mutation/include -o gml_to_csr
+ * usage: gml_to_csr [-n] input.gml output.csr
+ */
+#include "libmps.h"
+#include "csr_graph.h"
+
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+    bool keep_ids = true;
+    vector<string> args;
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) == "-n") keep_ids = false;
+        else args.push_back(argv[i]);
+    }
+    if (args.size() < 2) {
+        std::cerr << "usage: " << argv[0] << " [-n] input.gml output.csr" << std::endl;
+        return 1;
+    }
+
+    string input_file = args[0];
+    edge_list_graph G;
+    vector<long> node_ids;
+    if (!read_gml(input_file, G, &node_ids)) {
+        std::cerr << "Could not read " << input_file << std::endl;
+        return 1;
+    }
+
+    vector<int64_t> original_ids;
+    if (keep_ids) original_ids.assign(node_ids.begin(), node_ids.end());
+
+    string output_file = args[1];
+    if (!write_csr_graph(output_file, G.node_num, G.edges, original_ids)) {
+        std::cerr << "Could not write " << output_file << " (at most 2^31 edges fit)" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,37 @@
+//-----------------------------------------------------------------------------------
+// The solver as a library, without OGDF: see libmps.cpp.
+//-----------------------------------------------------------------------------------
+
+#ifndef _LIBMPS_H
+#define _LIBMPS_H
+
+#include "mps_graph.h"
+#include <string>
+
+//How a graph is searched. k_max and reruns are the arguments of dpt_planarizer, jobs,
+//islands and seed its -j, -i and --seed.
+struct mps_options {
+	int k_max = 100;
+	int reruns = 1;
+	int jobs = 1;
+	int islands = 1;
+	uint64_t seed = 0;
+	bool list_removed_edges = true; //Without it, only removed_edge_num is computed.
+};
+
+//The edges to remove for a maximal planar subgraph. A removed edge is given by the ids of its
+//end points; parallel edges are listed as often as they are removed, self-loops are never.
+struct mps_result {
+	int removed_edge_num = 0;
+	std::vector<std::pair<int, int> > removed_edges;
+};
+
+//Solve G block by block. All state lives in the call, so calls on different threads do not
+//interfere; G is only read.
+mps_result mps_solve(const edge_list_graph &G, const mps_options &options);
+mps_result mps_solve(const csr_graph_view &G, const mps_options &options);
+
+//Read a gml file into G, see gml_reader.cpp.
+bool read_gml(const std::string &input_file, edge_list_graph &G, std::vector<long> *original_ids = nullptr);
+
+#endif
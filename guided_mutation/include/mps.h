@@ -1,5 +1,5 @@
 //-----------------------------------------------------------------------------------
-// Header for modules: mps.cpp, mps_test.cpp, node.cpp.
+// Header for modules: mps.cpp, mps_test.cpp, mps_ogdf.cpp, node.cpp.
 //-----------------------------------------------------------------------------------
 
 #ifndef _MPS_H
@@ -13,108 +13,96 @@
 #include <cmath>
 #include <limits>
 #include <random>
+#include <cstdint>
 #include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
 #include <stack>
+#include <memory>
+#include "mps_graph.h"
+#ifndef MPS_NO_OGDF
 #include <ogdf/fileformats/GraphIO.h>
+#endif
 
 using namespace std;
 
 class node;
+class node_pool;
 class maximal_planar_subgraph_finder;
 
-enum label {
+enum label : unsigned char {
 	NOT_VISITED = 0,
 	ARTIFICIAL_EDGE = 1,
 	BOUNDARY_PATH = 2,
 	DELETED = 3
 };
 
-enum node_type {
+enum node_type : unsigned char {
 	P_NODE = 0,
 	C_NODE = 1,
 	REPLICA_NODE = 2,
 	AE_VIRTUAL_ROOT = 3
 };
 
-enum mark_type {
+enum mark_type : unsigned char {
     UNMARKED = 0,
     MARKED = 1,
     RESERVED = 2,
 };
 
+//Handle of a node in its node_pool. The handle 0 is the null node.
+typedef unsigned int node_ref;
+
+//A list of node handles in the shared list storage of a node_pool.
+struct ref_list {
+	unsigned int begin; //Position of the first element in the storage, 0 if no block is held.
+	unsigned int size;
+};
+
+//A node of the PC-tree, linked to other nodes by 32-bit handles.
+//Everything that has to follow a handle (children, essential nodes, AE-roots, replicas)
+//is done by maximal_planar_subgraph_finder, which owns the node_pool.
+//Data only P-nodes have (id, mark, unmarked count) is kept by the finder, indexed by node id.
 class node
 {
 public:
 	//CONSTRUCTOR
-	node(node_type t);
+	node(node_type t = P_NODE);
+	void reinit(node_type t);
+	void reset();
 
 	//DESTRUCTOR
 	~node() {}
 
-	//TYPE, ID, INDEX
+	//TYPE, INDEX
     node_type type();
 	int post_order_index();
-	void set_id(int i);
 	void set_post_order_index(int i);
-	void recursively_labeling();
-	int node_id();
-
-	//DFS-TREE
-	void add_adj(node* n);
-	int degree();
-	node* adj(int i);
-	void set_adj_list(vector<node*> vec);
-	void DFS_visit(vector<node*> &dfsList, int &index);
-    void guided_DFS_visit(vector<node *> &dfsList,
-                          const vector<node *> &node_list,
-                          int &return_index,
-                          const unordered_map<int, int> &node_id_to_pos);
-    void mutated_DFS_visit(vector<node *> &dfsList,
-                           const vector<node *> &node_list,
-                           int &index,
-                           int &traversal_index,
-                           const unordered_map<int, int> &node_id_to_pos,
-                           int mutate_point,
-                           mt19937 rng);
-
-    // custom comparator function to sort nodes according to order in given vector
-    bool sortByOrder(const unordered_map<int, int>& node_id_to_pos, node* a, node* b); 
-    bool sortByFreeNeighbors(node* a, node* b);
 
 	//PARENT-CHILDREN
-	void set_parent(node* n) ;
-	node* parent();
+	void set_parent(node_ref n) ;
+	node_ref parent();
 	int child_num();
-	node* child(int i);
-	void add_child(node* n);
 	void clear_children();
-	void remove_child(int i);
-	void remove_child(node* n);
-	vector<node*>* get_children_list();
+	ref_list &children();
 
 	//BOUNDARY_PATH
-	void set_to_boundary_path(node* n0, node* n1);
-	void set_neighbor(int i, node* n);
-	void set_neighbor(node* u, node* v);
-	node* neighbor(int i);
-	node* get_next(node* prev);
+	void set_to_boundary_path(node_ref n0, node_ref n1);
+	void set_neighbor(int i, node_ref n);
+	void set_neighbor(node_ref u, node_ref v);
+	node_ref neighbor(int i);
+	node_ref get_next(node_ref prev);
 
 	//ARTIFICIAL EDGE
-	node* AE(int i);
-	void set_AE(int i, node* j);
-	void add_AE(node* j);
-	void inherit_AE(node* u);
-	void init_AE(node* u);
+	node_ref AE(int i);
+	void set_AE(int i, node_ref j);
 
 	//REPLICA
-	node* original_node();
-	node* get_c_node();
-	void set_c_node(node* c);
+	node_ref original_node();
+	void set_original_node(node_ref u);
+	node_ref get_c_node();
+	void set_c_node(node_ref c);
 	bool is_sentinel();
-	static bool is_same(node* n1, node* n2);
-	void init_replica(node* u, node* c);
 
 	//LABELING
 	void set_1st_label(int i);
@@ -123,133 +111,243 @@ public:
 	label get_2nd_label();
 
 	//C-NODE
-	node* get_a_list_node();
 	int c_node_size();
-	node* essential(int i);
 	void clear_essential();
-	void add_essential(node* u);
-
-	//MARK
-	void mark();
-	static void init_mark();
-	void un_mark();
-	bool is_marked();
-
-	//Mark
-	mark_type _mark;
-
-    // keep track of unmarked neighbors
-    void add_unmarked();
-    int get_unmarked_count();
-
-
-
-    // made public for access by iterative
-	vector<node*> _adj_list;
+	ref_list &essential_list();
 
 private:
-	//Basic information.
-	node_type _type;
-	pair<int, label> _label;
-
 	//Information about neighborhood.
-	node* _neighbor[2];
-	node* _AE_root[2];
+	node_ref _neighbor[2];
+	node_ref _AE_root[2];
 
 	//Information about higher hierarchy.
-	node* _original_node; 
-    node* _c_node;
+	node_ref _original_node; 
+    node_ref _c_node;
 
 	//Information about parent-children relation.
-	node* _parent;
-	vector<node*> _children;
+	node_ref _parent;
+	ref_list _children;
 
 	//Information about about p-nodes in DFS-tree
-	// vector<node*> _adj_list;
 	int _post_order_index;
-	int _node_id;
 
 	//List of essential nodes in c-node
-	vector<node*> _essential_list;
+	ref_list _essential_list;
 
-    // store number of unmarked neighbors
-    int _unmarked_neighbors_count;
+	//Basic information.
+	int _1st_label;
+	label _2nd_label;
+	node_type _type;
+};
 
+//Arena for the nodes of a finder, and the shared storage of their lists.
+//Nodes live in fixed-size chunks and are handed out in order; reset() releases all of them
+//at once. Released nodes are reinitialized on reuse, so a finder that is reused does not
+//go back to the allocator once warmed up.
+//A list holds a power-of-two block of the storage, whose capacity is kept in the slot
+//before it. A list that outgrows its block moves to a block twice as large and its old
+//block is put on a free list for that capacity.
+class node_pool
+{
+public:
+	node_pool();
+	node& operator[](node_ref r) {return _chunks[r >> CHUNK_BITS][r & (CHUNK_SIZE - 1)];}
+	node_ref get_new_node(node_type t);
+	void reset(size_t keep = 0);
+	size_t size();
+
+	//Lists of handles.
+	node_ref list_at(const ref_list &l, int i) {return _list_storage[l.begin + i];}
+	void list_push_back(ref_list &l, node_ref r);
+	void list_remove(ref_list &l, int i);
+
+private:
+	static const int CHUNK_BITS = 12;
+	static const node_ref CHUNK_SIZE = 1 << CHUNK_BITS;
+	unsigned int allocate_block(unsigned int capacity);
+
+	vector<unique_ptr<node[]> > _chunks;
+	size_t _used = 0; //Number of nodes handed out since the last reset, the null node included.
+	vector<node_ref> _list_storage;
+	vector<unsigned int> _free_blocks[32]; //Free blocks by log2 of their capacity.
 };
 
 class maximal_planar_subgraph_finder
 {
 public:
+	//Neighbor-ordering policies of dfs_kernel(), selected at compile time.
+	//uses_unmarked_count tells whether marking has to maintain the neighbors' unmarked counts.
+	struct natural_order { static const bool uses_unmarked_count = false; }; //Input order.
+	struct guided_order { static const bool uses_unmarked_count = false; }; //Increasing rank in the guiding post-order.
+	struct mutated_order { static const bool uses_unmarked_count = true; mutation_rng* rng; }; //Random, biased towards neighbors with few free neighbors.
+	//A node on the DFS path and the part of its neighbor row that is still to be scanned.
+	struct dfs_frame {
+		node_ref current_node;
+		const int* next;
+		const int* end;
+	};
+
 	maximal_planar_subgraph_finder();
 	~maximal_planar_subgraph_finder();
 
-    // functions that prepare state
+#ifndef MPS_NO_OGDF
+    // the same on an ogdf graph, which is converted to an edge_list_graph first, see mps_ogdf.cpp
     void init_from_graph(const ogdf::Graph &G);
 	vector<int> generate_post_order_iterative(const ogdf::Graph &G);
 	vector<int> generate_guided_post_order_iterative(const ogdf::Graph &G, const vector<int> &post_order);
-	vector<int> generate_mutated_post_order_iterative(const ogdf::Graph &G, const vector<int> &post_order, int mutate_point);
+	vector<int> generate_mutated_post_order_iterative(const ogdf::Graph &G, const vector<int> &post_order, int mutate_point, mutation_rng &rng);
+    void construct_connected_components(ogdf::Graph &G, ogdf::List<ogdf::Graph> &components);
+    void compute_mps(const ogdf::Graph &G, int mutate_point, vector<int> &post_order, int &return_edge_size, mutation_rng &rng);
+	int find_mps(const ogdf::Graph &G);
+	int compute_removed_edge_size(const ogdf::Graph &G, vector<int> post_order);
+#endif
 
+    // functions that prepare state
+    // init_from_graph builds the graph-derived state once; the overloads without a graph
+    // argument reuse it and only reset the state of the previous evaluation
+    void init_from_graph(const edge_list_graph &G);
+	vector<int> generate_post_order_iterative();
+	vector<int> generate_guided_post_order_iterative(const vector<int> &post_order);
+	vector<int> generate_mutated_post_order_iterative(const vector<int> &post_order, int mutate_point, mutation_rng &rng);
 
-    bool sort_by_order(const unordered_map<int, int>& node_id_to_pos, node* a, node* b); 
-    bool sort_by_free_neighbors(node* a, node* b);
 
-    void construct_connected_components(ogdf::Graph &G, ogdf::List<ogdf::Graph> &components);
-    struct PairHash {
-        size_t operator()(const pair<int, int>& p) const {
-            return hash<int>()(p.first) ^ hash<int>()(p.second);
-        }
-    };
+    void construct_connected_components(const csr_graph_view &G, connected_components &components);
+    void construct_biconnected_blocks(const csr_graph_view &G, vector<edge_list_graph> &blocks,
+                                      vector<vector<int> > *block_nodes = nullptr);
 
 
 	void post_order_traversal_iterative();
 	void guided_post_order_traversal_iterative(const vector<int> &post_order);
-	void mutated_post_order_traversal_iterative(const vector<int> &post_order, int mutate_point);
-    void dfs_cc(node* root_node, vector<node*> &return_node_list);
-    void dfs(node* root_node, int &post_order_id);
-    void dfs_guided(node* root_node, int &post_order_id, const unordered_map<int, int> &node_id_to_pos);
-    void dfs_mutated(node* root_node, int &post_order_id, 
-                    const unordered_map<int, int> &node_id_to_pos, 
-                    int mutate_point, int &traversal_index, mt19937 rng);
+	void mutated_post_order_traversal_iterative(const vector<int> &post_order, int mutate_point, mutation_rng &rng);
+    void dfs(node_ref root_node, int &post_order_id);
+    void dfs_guided(node_ref root_node, int &post_order_id);
+    void dfs_mutated(node_ref root_node, int &post_order_id, 
+                    int mutate_point, int &traversal_index, mutation_rng &rng);
+    template <class order_policy>
+    void dfs_kernel(order_policy order, int &post_order_id, vector<node_ref> &return_node_list,
+                    int &traversal_index, int open_limit);
+    template <class order_policy>
+    void open_node(node_ref u, order_policy order, int &traversal_index);
+    void row(node_ref u, natural_order, const int* &begin, const int* &end);
+    void row(node_ref u, guided_order, const int* &begin, const int* &end);
+    void row(node_ref u, mutated_order order, const int* &begin, const int* &end);
+    void selector_add(int r, int v);
+    int selector_kth(int k);
 
     // compute_mps combines functionality to reduce repeating object initialization
     // the results are returned by modifying mutable reference
-    void compute_mps(const ogdf::Graph &G, int mutate_point, vector<int> &post_order, int &return_edge_size);
-
-	int find_mps(const ogdf::Graph &G);
-	int compute_removed_edge_size(const ogdf::Graph &G, vector<int> post_order);
-	node* get_new_node(node_type t);
+    // a candidate that removes cutoff edges or more is abandoned, see back_edge_traversal()
+    void compute_mps(int mutate_point, vector<int> &post_order, int &return_edge_size, mutation_rng &rng, int cutoff = INT_MAX);
+
+	int compute_removed_edge_size(const vector<int> &post_order);
+	node_ref get_new_node(node_type t);
+	node& at(node_ref u) {return _node_pool[u];}
+	//Input nodes are P-nodes with handles 1..n in the order of their ids.
+	node_ref input_node(int id) {return id + 1;}
+	int node_id(node_ref u) {return u - 1;}
     void reset_state();
 	int output_removed_edge_size();
+	vector<pair<int, int> > output_removed_edges();
+	int back_edge_weight(size_t i) {return _back_edge_weight.empty() ? 1 : _back_edge_weight[i];}
     vector<int> return_post_order();
+    vector<int> return_oriented_post_order();
     void print_post_order();
     void print_edge_list();
+	int degree(node_ref u);
+	void set_rank(const vector<int> &post_order);
+	bool is_marked(node_ref u);
+	void mark(node_ref u);
+	void mark_counted(node_ref u);
+	void init_unmarked_counts();
 	void sort_adj_list();
 	void determine_edges();
-	void back_edge_traversal();
-	bool back_edge_traversal(node* traverse_node, int index);
-	void make_essential(node* p_node, node* c_node);
-	node* find(node* n);
-	void merge(pair<pair<node*, node*>, pair<node*, node*> > boundary, node* list_node);
-	void eliminate(node* u);
-	void eliminate_AE(node* u, node* v);
-	pair<pair<node*, node*>, pair<node*, node*> > trim(node* u);
-	void c_node_extension(node* c_node);
-	void recursively_shaving(node* u);
-	pair<node*, node*> shave(node* x);
-	pair<node*, node*> parallel_search_sentinel(node* x, node* &c);
-	pair<node*, node*> parallel_search_sentinel(node* n0, node* n0_prev, node* n1, node* n1_prev, node* & c);
-	pair<node*, node*> count_sentinel_elimination(pair<node*, node*> sentinel_1, int num_sentinel);
-	node* construct(node* u);
-	node* construct(node* c, node* p);
-	void parenting_labeling_shaving(node* u, node* node_i) ;
+	bool back_edge_traversal(int cutoff = INT_MAX);
+	bool back_edge_traversal(node_ref traverse_node, int index);
+	void make_essential(node_ref p_node, node_ref c_node);
+	node_ref find(node_ref n);
+	void merge(pair<pair<node_ref, node_ref>, pair<node_ref, node_ref> > boundary, node_ref list_node);
+	void eliminate(node_ref u);
+	void eliminate_AE(node_ref u, node_ref v);
+	pair<pair<node_ref, node_ref>, pair<node_ref, node_ref> > trim(node_ref u);
+	void c_node_extension(node_ref c_node);
+	void recursively_shaving(node_ref u);
+	pair<node_ref, node_ref> shave(node_ref x);
+	pair<node_ref, node_ref> parallel_search_sentinel(node_ref x, node_ref &c);
+	pair<node_ref, node_ref> parallel_search_sentinel(node_ref n0, node_ref n0_prev, node_ref n1, node_ref n1_prev, node_ref & c);
+	pair<node_ref, node_ref> count_sentinel_elimination(pair<node_ref, node_ref> sentinel_1, int num_sentinel);
+	node_ref construct(node_ref u);
+	node_ref construct(node_ref c, node_ref p);
+	void parenting_labeling_shaving(node_ref u, node_ref node_i) ;
+
+	//Node operations that follow handles, see node.cpp.
+	void recursively_labeling(node_ref u);
+	node_ref child(node_ref u, int i);
+	void add_child(node_ref u, node_ref n);
+	void remove_child(node_ref u, int i);
+	void remove_child(node_ref u, node_ref n);
+	void set_AE(node_ref u, int i, node_ref j);
+	void add_AE(node_ref u, node_ref j);
+	void inherit_AE(node_ref u, node_ref v);
+	void init_AE(node_ref u, node_ref v);
+	bool is_same(node_ref n1, node_ref n2);
+	void init_replica(node_ref u, node_ref v, node_ref c);
+	node_ref get_a_list_node(node_ref c);
+	node_ref essential(node_ref c, int i);
+	void add_essential(node_ref c, node_ref u);
 
 private:
-	vector<node*> _node_list; //List of nodes input.
-	vector<pair<node*, node*> > _edge_list; // Edges in DFS-tree. These edges must be contained in the maximal planar subgraph that we found.
-	vector<node*> _post_order_list; //The sorted version (increasing with post-order-index) of _node_list.
-	vector<pair<node*, node*> > _back_edge_list; // Edges other than that in DFS-tree. (The first node's index is higher than the second's.)
+	int _node_num = 0; //Number of input nodes.
+	//Input adjacency in compressed-sparse-row form: the neighbors of node id v, in input order,
+	//are _adj_target[_adj_offset[v]] ... _adj_target[_adj_offset[v+1]-1].
+	vector<int> _adj_offset;
+	vector<int> _adj_target;
+	//Number of parallel input edges behind each entry of _adj_target, empty if the input is simple.
+	vector<int> _adj_weight;
+	//Adjacency sorted increasingly by post-order-index, rows and entries are post-order-indices.
+	//Rebuilt by sort_adj_list() for every DFS-tree.
+	vector<int> _sorted_adj_offset;
+	vector<int> _sorted_adj_target;
+	vector<int> _sorted_adj_weight; //Same layout as _sorted_adj_target, empty if the input is simple.
+	vector<int> _adj_fill; //Write cursor per row, used by the counting sorts.
+	vector<int> _rank; //Position of each node id in the reversed guiding post-order.
+	vector<int> _ranked_adj_target; //Input rows sorted by _rank, same offsets as _adj_target.
+	vector<int> _mutated_adj_target; //Rows permuted by the mutated traversal, same offsets as _adj_target.
+	vector<dfs_frame> _dfs_stack; //Frames of the current DFS path.
+	//P-node data, indexed by node id.
+	vector<mark_type> _mark;
+	vector<int> _unmarked_count; //Number of unmarked neighbors.
+	//Work stacks that replace recursion in the back-edge-traversal and the PC-tree maintenance.
+	vector<pair<node_ref, node_ref> > _traversal_path; //(traverse_node, parent_node) steps of back_edge_traversal(node_ref, int).
+	vector<pair<pair<pair<node_ref, node_ref>, pair<node_ref, node_ref> >, node_ref> > _find_stack; //(boundary, c-node) still to merge in find().
+	vector<node_ref> _eliminate_stack;
+	vector<node_ref> _shaving_stack;
+	vector<node_ref> _labeling_stack;
+	//Scratch lists of the PC-tree helpers, cleared on each call instead of reallocated.
+	vector<node_ref> _trim_path; //The path traversed by trim().
+	vector<node_ref> _traversed; //Nodes passed by parallel_search_sentinel().
+	vector<node_ref> _u_i_path; //The [u, node_i] path of parenting_labeling_shaving().
+	vector<node_ref> _new_child_list; //The two children recursively_shaving() keeps in a c-node.
+	bool _unmarked_counts_valid = false; //Whether the unmarked counts match the marks.
+	//Scratch of row(mutated_order): (free neighbor count, position) sorted, rank per position, Fenwick tree over ranks.
+	vector<pair<int, int> > _selector_keys;
+	vector<int> _selector_rank;
+	vector<int> _selector_tree;
+	vector<pair<node_ref, node_ref> > _edge_list; // Edges in DFS-tree. These edges must be contained in the maximal planar subgraph that we found.
+	vector<node_ref> _post_order_list; //The sorted version (increasing with post-order-index) of the input nodes.
+	vector<node_ref> _open_order; //The input nodes in the order the traversal reached them.
+	vector<pair<node_ref, node_ref> > _back_edge_list; // Edges other than that in DFS-tree. (The first node's index is higher than the second's.)
 	vector<bool> _is_back_edge_eliminate; //Record that if the back-edge has been eliminated or not.
-	vector<node*> _new_node_list; //Newly added nodes.
+	vector<int> _back_edge_weight; //Number of input edges behind each back-edge, empty if the input is simple.
+	int _eliminated_num = 0; //Number of input edges behind the true entries of _is_back_edge_eliminate.
+	node_pool _node_pool; //Owns the input nodes and all newly added nodes.
 };
 
+//Functions on edge_list_graph and csr_graph_view, defined in mps_test.cpp.
+void build_csr(const edge_list_graph &G, vector<unsigned int> &offset, vector<unsigned int> &target);
+void construct_connected_components(const csr_graph_view &G, connected_components &components);
+void construct_biconnected_blocks(const csr_graph_view &G, vector<edge_list_graph> &blocks,
+                                  vector<vector<int> > *block_nodes);
+void reduce_graph(const edge_list_graph &G, edge_list_graph &kernel, vector<vector<int> > *edge_sets);
+int compute_removed_edge_size(const edge_list_graph &G, const vector<int> &post_order);
+
 #endif // for MPS_H
@@ -0,0 +1,98 @@
+//-----------------------------------------------------------------------------------
+// Graph types and the random number generator of the search, free of OGDF.
+//-----------------------------------------------------------------------------------
+
+#ifndef _MPS_GRAPH_H
+#define _MPS_GRAPH_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+//A graph as its number of nodes and its edges over the node ids 0 .. node_num-1.
+//This is what the finder is built from; ogdf graphs are converted to it.
+struct edge_list_graph {
+	int node_num = 0;
+	std::vector<std::pair<int, int> > edges;
+};
+
+//A graph in compressed sparse row form: the neighbors of node i are target[offset[i]] ...
+//target[offset[i+1]-1], every edge is listed at both end points. The arrays are not owned;
+//a mapped file keeps them, see graph_processing/csr_graph.h.
+struct csr_graph_view {
+	int node_num = 0;
+	const unsigned int* offset = nullptr;
+	const unsigned int* target = nullptr;
+};
+
+//The connected components of a graph, found in one pass. The graph is stored once more as a
+//CSR whose nodes are renumbered so that every component is a range of them, and whose targets
+//are ids within the component; component(i) is a view into it, nothing is copied per component.
+//original_id[x] is the id in the input graph of node x of the renumbered CSR.
+struct connected_components {
+	std::vector<unsigned int> offset;
+	std::vector<unsigned int> target;
+	std::vector<int> original_id;
+	std::vector<int> node_begin; //Component i is the nodes node_begin[i] .. node_begin[i+1]-1.
+	int size() const {return node_begin.size() - 1;}
+	csr_graph_view component(int i) const;
+};
+
+//The random number generator of a search: xoshiro256**, 256 bits of state seeded by splitmix64.
+//A search owns one and passes it by reference. Every thread, block or graph of a search draws
+//from its own substream, so a seeded run makes the same draws however its work is scheduled.
+class mutation_rng {
+public:
+	typedef uint64_t result_type;
+
+	explicit mutation_rng(uint64_t seed = 0) : _seed(seed) {
+		for (int i = 0; i < 4; ++i) _s[i] = splitmix64(seed);
+	}
+
+	//The generator of the i-th piece of work, and its seed; this one is not advanced.
+	mutation_rng substream(uint64_t i) const {return mutation_rng(substream_seed(i));}
+	uint64_t substream_seed(uint64_t i) const {
+		uint64_t x = _seed ^ (0x9E3779B97F4A7C15ull * (i + 1));
+		return splitmix64(x);
+	}
+
+	static constexpr result_type min() {return 0;}
+	static constexpr result_type max() {return UINT64_MAX;}
+
+	result_type operator()() {
+		uint64_t result = rotl(_s[1] * 5, 7) * 9;
+		uint64_t t = _s[1] << 17;
+		_s[2] ^= _s[0];
+		_s[3] ^= _s[1];
+		_s[1] ^= _s[2];
+		_s[0] ^= _s[3];
+		_s[2] ^= t;
+		_s[3] = rotl(_s[3], 45);
+		return result;
+	}
+
+	//Uniform in [low, high], by multiply and shift with rejection of the biased low part.
+	int uniform(int low, int high) {
+		uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(high) - low) + 1;
+		uint64_t product = ((*this)() >> 32) * range;
+		if (static_cast<uint32_t>(product) < range) {
+			uint32_t threshold = static_cast<uint32_t>(-range) % range;
+			while (static_cast<uint32_t>(product) < threshold) product = ((*this)() >> 32) * range;
+		}
+		return low + static_cast<int>(product >> 32);
+	}
+
+private:
+	static uint64_t rotl(uint64_t x, int k) {return (x << k) | (x >> (64 - k));}
+	static uint64_t splitmix64(uint64_t &x) {
+		uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	uint64_t _seed;
+	uint64_t _s[4];
+};
+
+#endif
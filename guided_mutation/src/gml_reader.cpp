@@ -0,0 +1,189 @@
+//-----------------------------------------------------------------------------------
+// A GML reader for the solver path: only node ids and edges are read.
+//-----------------------------------------------------------------------------------
+
+#include "mps.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+
+// the file is mapped and scanned once, token by token
+// keys and values are told apart by position only where it matters: a number is taken as a node
+// id if the last key was "id" directly inside a node list, and as an end point if the last key was
+// "source" or "target" directly inside an edge list; every other key, value, string and nested
+// list (labels, graphics, ...) is skipped
+// nodes get ids 0, 1, ... in the order they appear, which is the index readGML gives them, and the
+// edges keep the order of the file
+namespace {
+
+enum gml_item { NO_ITEM, NODE_ITEM, EDGE_ITEM };
+
+bool is_key(const char *begin, const char *end, const char *key) {
+    size_t length = strlen(key);
+    return static_cast<size_t>(end - begin) == length && memcmp(begin, key, length) == 0;
+}
+
+// a token that is not a decimal number, or does not fit a long, is rejected; an id, source or
+// target without a number makes the read fail
+bool parse_long(const char *begin, const char *end, long &value) {
+    bool negative = false;
+    if (begin != end && (*begin == '-' || *begin == '+')) {
+        negative = (*begin == '-');
+        ++begin;
+    }
+    if (begin == end) return false;
+    value = 0;
+    for (; begin != end; ++begin) {
+        if (*begin < '0' || *begin > '9') return false;
+        int digit = *begin - '0';
+        if (value > (LONG_MAX - digit) / 10) return false;
+        value = value * 10 + digit;
+    }
+    if (negative) value = -value;
+    return true;
+}
+
+bool parse_gml(const char *p, const char *end, edge_list_graph &G, vector<long> *original_ids) {
+    vector<long> node_ids;
+    vector<pair<long, long> > raw_edges;
+    int depth = 0;
+    gml_item item = NO_ITEM;
+    int item_depth = 0;
+    const char *key_begin = nullptr;
+    const char *key_end = nullptr;
+    long id = 0, source = 0, target = 0;
+    bool has_id = false, has_source = false, has_target = false;
+
+    while (p != end) {
+        char c = *p;
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            ++p;
+        } else if (c == '#') {
+            while (p != end && *p != '\n') ++p;
+        } else if (c == '"') {
+            ++p;
+            while (p != end && *p != '"') ++p;
+            if (p != end) ++p;
+            key_begin = key_end = nullptr;
+        } else if (c == '[') {
+            ++depth;
+            if (item == NO_ITEM && key_begin != nullptr) {
+                if (is_key(key_begin, key_end, "node")) item = NODE_ITEM;
+                else if (is_key(key_begin, key_end, "edge")) item = EDGE_ITEM;
+                if (item != NO_ITEM) {
+                    item_depth = depth;
+                    has_id = has_source = has_target = false;
+                }
+            }
+            key_begin = key_end = nullptr;
+            ++p;
+        } else if (c == ']') {
+            if (item != NO_ITEM && depth == item_depth) {
+                if (item == NODE_ITEM) {
+                    if (!has_id) return false;
+                    node_ids.push_back(id);
+                } else {
+                    if (!has_source || !has_target) return false;
+                    raw_edges.push_back(make_pair(source, target));
+                }
+                item = NO_ITEM;
+            }
+            --depth;
+            key_begin = key_end = nullptr;
+            ++p;
+        } else {
+            const char *token = p;
+            while (p != end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r' && *p != '[' && *p != ']') ++p;
+            bool is_value = (key_begin != nullptr);
+            if (!is_value) {
+                key_begin = token;
+                key_end = p;
+                continue;
+            }
+            if (item != NO_ITEM && depth == item_depth) {
+                long value;
+                if (item == NODE_ITEM && is_key(key_begin, key_end, "id") && parse_long(token, p, value)) {
+                    id = value;
+                    has_id = true;
+                } else if (item == EDGE_ITEM && is_key(key_begin, key_end, "source") && parse_long(token, p, value)) {
+                    source = value;
+                    has_source = true;
+                } else if (item == EDGE_ITEM && is_key(key_begin, key_end, "target") && parse_long(token, p, value)) {
+                    target = value;
+                    has_target = true;
+                }
+            }
+            key_begin = key_end = nullptr;
+        }
+    }
+
+    // map the ids of the file to 0, 1, ...: by array if they are small, by hash otherwise
+    G.node_num = node_ids.size();
+    if (original_ids != nullptr) *original_ids = node_ids;
+    G.edges.clear();
+    G.edges.reserve(raw_edges.size());
+    long max_id = -1;
+    bool small_ids = true;
+    for (long node_id : node_ids) {
+        if (node_id < 0) small_ids = false;
+        max_id = std::max(max_id, node_id);
+    }
+    if (max_id > 4 * static_cast<long>(node_ids.size()) + 1024) small_ids = false;
+    if (small_ids) {
+        vector<int> index(max_id + 1, -1);
+        for (size_t i = 0; i < node_ids.size(); ++i) {
+            if (index[node_ids[i]] == -1) index[node_ids[i]] = i;
+        }
+        for (const pair<long, long> &e : raw_edges) {
+            if (e.first < 0 || e.first > max_id || e.second < 0 || e.second > max_id) return false;
+            int s = index[e.first];
+            int t = index[e.second];
+            if (s == -1 || t == -1) return false;
+            G.edges.push_back(make_pair(s, t));
+        }
+    } else {
+        unordered_map<long, int> index;
+        index.reserve(node_ids.size());
+        for (size_t i = 0; i < node_ids.size(); ++i) {
+            index.emplace(node_ids[i], i);
+        }
+        for (const pair<long, long> &e : raw_edges) {
+            auto s = index.find(e.first);
+            auto t = index.find(e.second);
+            if (s == index.end() || t == index.end()) return false;
+            G.edges.push_back(make_pair(s->second, t->second));
+        }
+    }
+    return true;
+}
+
+}
+
+// read a gml file into G, return false if it cannot be read or an edge names an unknown node
+// if original_ids is given, it receives the id in the file of every node of G
+bool read_gml(const string &input_file, edge_list_graph &G, vector<long> *original_ids) {
+    int fd = open(input_file.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        return false;
+    }
+    size_t size = file_stat.st_size;
+    if (size == 0) {
+        close(fd);
+        G = edge_list_graph();
+        if (original_ids != nullptr) original_ids->clear();
+        return true;
+    }
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+    madvise(data, size, MADV_SEQUENTIAL);
+    const char *begin = static_cast<const char*>(data);
+    bool ok = parse_gml(begin, begin + size, G, original_ids);
+    munmap(data, size);
+    return ok;
+}
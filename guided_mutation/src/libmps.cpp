@@ -0,0 +1,368 @@
+//-----------------------------------------------------------------------------------
+// The search, and the entry points of libmps.
+//-----------------------------------------------------------------------------------
+
+#include "mps.h"
+#include "libmps.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// the mutations draw from rng, which is advanced
+vector<int> repeated_mutation(const edge_list_graph &G, int k_max, int reruns, mutation_rng &rng) {
+    // the finder is built from the graph once and reset between evaluations
+    maximal_planar_subgraph_finder m;
+    m.init_from_graph(G);
+
+    // generate first post order
+    vector<int> best_order = m.generate_post_order_iterative();
+    vector<int> current_order = best_order;
+    int new_removed_size;
+    int best_removed_size = INT_MAX;
+
+    // variables to manage exponential mutate_index iteration
+    int index_range = best_order.size() - 1; // assumes start from 0
+    int index_start = 0;
+    // given k_max and number of range for mutate_index, we compute growth factor
+    // so that at mutate_factor spans index_range in an exponential rate
+    double growth_factor = std::log(index_range + 1) / (k_max);
+    int mutate_index = 0;
+
+    for (int r = 0; r < reruns; ++r) {
+
+        for (int k = 0; k < k_max; ++k) {
+            // update mutate_index based on exponential rate wrt k
+            mutate_index = index_start + static_cast<int>(std::exp(growth_factor * k) - 1);
+
+            // compute_mps returns the order already rotated back, read off its mutated traversal
+            // function will return via reference to current_order and new_removed_size
+            // a candidate is abandoned as soon as it can no longer beat best_removed_size
+            m.compute_mps(mutate_index, current_order, new_removed_size, rng, best_removed_size);
+
+
+            // if there is an improvement
+            // 1. update the removed size to use the new smaller size
+            // 2. update the old_order to be the new_order
+            if (new_removed_size < best_removed_size) {
+                best_removed_size = new_removed_size;
+                best_order = current_order;
+            // if there is no improvement, we revert the temp_order to the old_order
+            } else {
+                current_order = best_order;
+            }
+        }
+    }
+    return best_order;
+}
+
+
+// a barrier for a fixed number of threads that can be passed again and again
+class batch_barrier {
+public:
+    explicit batch_barrier(int count) : _count(count) {}
+
+    void arrive_and_wait() {
+        unique_lock<mutex> lock(_mutex);
+        int generation = _generation;
+        if (++_arrived == _count) {
+            _arrived = 0;
+            ++_generation;
+            _passed.notify_all();
+            return;
+        }
+        _passed.wait(lock, [&]() { return _generation != generation; });
+    }
+
+private:
+    mutex _mutex;
+    condition_variable _passed;
+    int _count;
+    int _arrived = 0;
+    int _generation = 0;
+};
+
+
+// parallel version of repeated_mutation
+// the schedule is walked in batches of jobs mutate indices; the candidates of a batch all mutate
+// the current best order and are evaluated concurrently, one worker and one finder per candidate
+// the best candidate of a batch is accepted if it improves, so the number of evaluations is the
+// same as for repeated_mutation, but an improvement is only seen by the next batch
+// the workers live for the whole search and meet at a barrier before and after every batch;
+// the calling thread is worker 0 and picks the best candidate in between
+// the candidate of worker t draws from substream t of rng
+vector<int> repeated_mutation_parallel(const edge_list_graph &G, int k_max, int reruns, int jobs,
+                                       const mutation_rng &rng) {
+    // a batch never has more than k_max candidates, more workers would only sit idle
+    int workers = std::max(1, std::min(jobs, k_max));
+    vector<maximal_planar_subgraph_finder> finders(workers);
+    vector<mutation_rng> rngs;
+    for (int t = 0; t < workers; ++t) rngs.push_back(rng.substream(t));
+
+    vector<int> best_order;
+    int best_removed_size = INT_MAX;
+    vector<vector<int> > candidate_order(workers);
+    vector<int> candidate_removed_size(workers);
+
+    // same exponential mutate_index schedule as repeated_mutation
+    int index_start = 0;
+    double growth_factor = 0;
+    // the batch being evaluated is k ... k + batch - 1, a batch of 0 stops the workers
+    int k = 0;
+    int batch = 0;
+    batch_barrier barrier(workers);
+
+    auto evaluate = [&](int t) {
+        if (t >= batch) return;
+        int mutate_index = index_start + static_cast<int>(std::exp(growth_factor * (k + t)) - 1);
+        candidate_order[t] = best_order;
+        finders[t].compute_mps(mutate_index, candidate_order[t], candidate_removed_size[t], rngs[t], best_removed_size);
+    };
+    // every worker owns a finder, built from the graph once
+    vector<thread> threads;
+    for (int t = 1; t < workers; ++t) {
+        threads.emplace_back([&, t]() {
+            finders[t].init_from_graph(G);
+            while (true) {
+                barrier.arrive_and_wait();
+                if (batch == 0) return;
+                evaluate(t);
+                barrier.arrive_and_wait();
+            }
+        });
+    }
+    finders[0].init_from_graph(G);
+
+    // generate first post order
+    best_order = finders[0].generate_post_order_iterative();
+    int index_range = best_order.size() - 1; // assumes start from 0
+    growth_factor = std::log(index_range + 1) / (k_max);
+
+    for (int r = 0; r < reruns; ++r) {
+        for (k = 0; k < k_max; k += workers) {
+            batch = std::min(workers, k_max - k);
+            barrier.arrive_and_wait();
+            evaluate(0);
+            barrier.arrive_and_wait();
+
+            // accept the best candidate of the batch, the first one on ties
+            int best_candidate = -1;
+            for (int t = 0; t < batch; ++t) {
+                if (candidate_removed_size[t] < best_removed_size) {
+                    best_removed_size = candidate_removed_size[t];
+                    best_candidate = t;
+                }
+            }
+            if (best_candidate >= 0) best_order.swap(candidate_order[best_candidate]);
+        }
+    }
+    batch = 0;
+    barrier.arrive_and_wait();
+    for (auto &thread : threads) thread.join();
+    return best_order;
+}
+
+
+// island model: every island runs the loop of repeated_mutation on its own finder and thread,
+// island 0 from the first post order and the others from a random root and fully mutated order
+// ISLAND_EXCHANGES times per pass of the schedule, the islands meet at a barrier: each one posts
+// its best order, and then continues from the best posted one if that is better than its own,
+// the lowest island on ties
+// island t draws from substream t of rng
+const int ISLAND_EXCHANGES = 4;
+
+// the best order an island has posted
+struct incumbent {
+    int removed_size = INT_MAX;
+    vector<int> order;
+};
+
+int best_incumbent(const vector<incumbent> &posted) {
+    int best = 0;
+    for (size_t t = 1; t < posted.size(); ++t) {
+        if (posted[t].removed_size < posted[best].removed_size) best = t;
+    }
+    return best;
+}
+
+vector<int> repeated_mutation_islands(const edge_list_graph &G, int k_max, int reruns, int islands,
+                                      const mutation_rng &rng) {
+    vector<incumbent> posted(islands);
+    batch_barrier barrier(islands);
+    vector<thread> workers;
+    for (int t = 0; t < islands; ++t) {
+        workers.emplace_back([&, t]() {
+            maximal_planar_subgraph_finder m;
+            m.init_from_graph(G);
+            mutation_rng island_rng = rng.substream(t);
+
+            vector<int> best_order = m.generate_post_order_iterative();
+            if (t > 0) best_order = m.generate_mutated_post_order_iterative(best_order, 0, island_rng);
+            vector<int> current_order = best_order;
+            int new_removed_size;
+            int best_removed_size = INT_MAX;
+
+            int index_range = best_order.size() - 1; // assumes start from 0
+            int index_start = 0;
+            double growth_factor = std::log(index_range + 1) / (k_max);
+            int exchange_interval = std::max(1, k_max / ISLAND_EXCHANGES);
+
+            for (int r = 0; r < reruns; ++r) {
+                for (int k = 0; k < k_max; ++k) {
+                    int mutate_index = index_start + static_cast<int>(std::exp(growth_factor * k) - 1);
+                    m.compute_mps(mutate_index, current_order, new_removed_size, island_rng, best_removed_size);
+                    if (new_removed_size < best_removed_size) {
+                        best_removed_size = new_removed_size;
+                        best_order = current_order;
+                    } else {
+                        current_order = best_order;
+                    }
+
+                    // every island runs the same schedule, so all of them stop at the same k
+                    if ((k + 1) % exchange_interval == 0 || k + 1 == k_max) {
+                        if (best_removed_size < posted[t].removed_size) {
+                            posted[t].removed_size = best_removed_size;
+                            posted[t].order = best_order;
+                        }
+                        barrier.arrive_and_wait();
+                        int best = best_incumbent(posted);
+                        if (posted[best].removed_size < best_removed_size) {
+                            best_removed_size = posted[best].removed_size;
+                            best_order = posted[best].order;
+                            current_order = best_order;
+                        }
+                        // nobody posts again before everyone has read
+                        barrier.arrive_and_wait();
+                    }
+                }
+            }
+            // an island without any evaluation still leaves its order
+            if (posted[t].order.empty()) {
+                posted[t].removed_size = best_removed_size;
+                posted[t].order = best_order;
+            }
+        });
+    }
+    for (auto &worker : workers) worker.join();
+    return posted[best_incumbent(posted)].order;
+}
+
+
+// search one block (or component) and return its number of removed edges
+// jobs and islands are the threads the search itself may use
+// the search runs on the reduced kernel, which removes as many edges as the block itself
+// with removed_edges, the removed edges of the block are added to it, by the block's node ids
+int solve_component(const edge_list_graph &component, int k_max, int reruns, int jobs, int islands,
+                    mutation_rng &rng, vector<pair<int, int> > *removed_edges) {
+    edge_list_graph kernel;
+    vector<vector<int> > edge_sets;
+    reduce_graph(component, kernel, removed_edges != nullptr ? &edge_sets : nullptr);
+    if (kernel.edges.empty()) return 0;
+    vector<int> post_order;
+    if (islands > 1) post_order = repeated_mutation_islands(kernel, k_max, reruns, islands, rng);
+    else if (jobs > 1) post_order = repeated_mutation_parallel(kernel, k_max, reruns, jobs, rng);
+    else post_order = repeated_mutation(kernel, k_max, reruns, rng);
+    if (removed_edges == nullptr) return compute_removed_edge_size(kernel, post_order);
+
+    maximal_planar_subgraph_finder m;
+    m.init_from_graph(kernel);
+    int removed_edge_num = m.compute_removed_edge_size(post_order);
+    // the copies of a bundle follow each other in kernel.edges, the i-th bundle has edge_sets[i]
+    unordered_map<long, int> bundle;
+    for (const pair<int, int> &e : kernel.edges) {
+        long key = static_cast<long>(std::min(e.first, e.second)) * kernel.node_num + std::max(e.first, e.second);
+        bundle.emplace(key, bundle.size());
+    }
+    for (const pair<int, int> &e : m.output_removed_edges()) {
+        long key = static_cast<long>(std::min(e.first, e.second)) * kernel.node_num + std::max(e.first, e.second);
+        for (int i : edge_sets[bundle[key]]) removed_edges->push_back(component.edges[i]);
+    }
+    return removed_edge_num;
+}
+
+
+// solve a whole graph block by block
+// with jobs > 1, blocks are solved by jobs threads, largest first
+// a graph with a single block uses them for candidates instead, see repeated_mutation_parallel
+// the i-th largest block draws from substream i of the seed
+mps_result mps_solve(const csr_graph_view &G, const mps_options &options) {
+    mutation_rng rng(options.seed);
+    int jobs = std::max(1, options.jobs);
+    int islands = std::max(1, options.islands);
+
+    // lets create graphs of the biconnected blocks, each is solved on its own
+    // they are found one connected component at a time, on views of the components
+    // components and blocks that are planar for sure (m - n + 1 < 4: trees, bridges, cycles, ...)
+    // are left out, they remove nothing
+    connected_components parts;
+    construct_connected_components(G, parts);
+    vector<edge_list_graph> components;
+    vector<vector<int> > block_nodes;
+    for (int p = 0; p < parts.size(); ++p) {
+        csr_graph_view part = parts.component(p);
+        long edge_num = (part.offset[part.node_num] - part.offset[0]) / 2;
+        if (edge_num - part.node_num + 1 < 4) continue;
+        size_t first = block_nodes.size();
+        construct_biconnected_blocks(part, components, options.list_removed_edges ? &block_nodes : nullptr);
+        // the block nodes are ids within the component
+        for (size_t b = first; b < block_nodes.size(); ++b) {
+            for (int &x : block_nodes[b]) x = parts.original_id[parts.node_begin[p] + x];
+        }
+    }
+
+    // the blocks are solved largest first
+    vector<int> work;
+    for (size_t c = 0; c < components.size(); ++c) {
+        if (!components[c].edges.empty()) work.push_back(c);
+    }
+    std::stable_sort(work.begin(), work.end(), [&components](int a, int b) {
+        return components[a].edges.size() > components[b].edges.size();
+    });
+
+    // the removed edges of every block are kept apart, so the list is the same for any jobs
+    vector<int> removed_edge_num(work.size(), 0);
+    vector<vector<pair<int, int> > > removed_edges(work.size());
+    auto solve = [&](size_t c, int component_jobs) {
+        mutation_rng block_rng = rng.substream(c);
+        removed_edge_num[c] = solve_component(components[work[c]], options.k_max, options.reruns,
+                                              component_jobs, islands, block_rng,
+                                              options.list_removed_edges ? &removed_edges[c] : nullptr);
+    };
+    if (jobs > 1 && work.size() > 1) {
+        // every worker takes the largest block left, so the big ones start first
+        // and the small ones fill the remaining threads
+        atomic<size_t> next_component{0};
+        vector<thread> workers;
+        for (size_t t = 0; t < std::min<size_t>(jobs, work.size()); ++t) {
+            workers.emplace_back([&]() {
+                for (size_t c = next_component++; c < work.size(); c = next_component++) solve(c, 1);
+            });
+        }
+        for (auto &worker : workers) worker.join();
+    } else {
+        for (size_t c = 0; c < work.size(); ++c) solve(c, jobs);
+    }
+
+    mps_result result;
+    for (size_t c = 0; c < work.size(); ++c) {
+        result.removed_edge_num += removed_edge_num[c];
+        if (!options.list_removed_edges) continue;
+        const vector<int> &nodes = block_nodes[work[c]];
+        for (const pair<int, int> &e : removed_edges[c]) {
+            result.removed_edges.push_back(make_pair(nodes[e.first], nodes[e.second]));
+        }
+    }
+    return result;
+}
+
+// the edge list is laid out as the rows of a CSR file would be, so both give the same result
+mps_result mps_solve(const edge_list_graph &G, const mps_options &options) {
+    vector<unsigned int> offset, target;
+    build_csr(G, offset, target);
+    csr_graph_view view;
+    view.node_num = G.node_num;
+    view.offset = offset.data();
+    view.target = target.data();
+    return mps_solve(view, options);
+}
@@ -2,7 +2,7 @@
 // A simple code that test the MPS algorighm.
 //-----------------------------------------------------------------------------------
 
-#include "mps.h"
+#include "libmps.h"
 #include <iostream>
 #include <cstdlib>
 #include <climits>
@@ -15,21 +15,19 @@
 #include <filesystem>
 #include <chrono>
 #include <cassert>
+#include <thread>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <fstream>
  
-#include <ogdf/fileformats/GraphIO.h>
+#include "csr_graph.h"
 
 using namespace std;
 
-// these functions are defined in mps_test.cpp
-// but their signatures are not in mps.h, hence they are declared here
-ogdf::Graph read_from_gml(string input_file);
-void construct_connected_components(ogdf::Graph &G, ogdf::List<ogdf::Graph> &components);
-vector<int> generate_post_order_iterative(const ogdf::Graph &G);
-vector<int> generate_guided_post_order_iterative(const ogdf::Graph &G, const vector<int> &post_order);
-vector<int> generate_mutated_post_order_iterative(const ogdf::Graph &G, const vector<int> &post_order, int mutate_point);
-void compute_mps(const ogdf::Graph &G, int mutate_point, vector<int> &post_order, int &return_edge_size);
-int compute_removed_edge_size(const ogdf::Graph &G, vector<int> post_order);
-
 void vector_printer(const vector<int>& state) {
     for (size_t i = 0; i < state.size(); ++i) {
         std::cout << state[i] << ",";
@@ -38,94 +36,270 @@ void vector_printer(const vector<int>& state) {
 }
 
 
-vector<int> repeated_mutation(const ogdf::Graph &G, int k_max, int reruns) {
-    // generate first post order
-    vector<int> best_order = generate_post_order_iterative(G);
-    vector<int> current_order = best_order;
-    int new_removed_size;
-    int best_removed_size = INT_MAX;
+// a graph as it is read from its file: a CSR file (see graph_processing/csr_graph.h) stays
+// mapped and is split into blocks in place, anything else is read as gml straight into an
+// edge list, see gml_reader.cpp
+struct loaded_graph {
+    string input_file;
+    bool is_csr = false;
+    csr_graph_file csr;
+    edge_list_graph G;
+};
+
+bool load_graph(const string &input_file, loaded_graph &graph) {
+    graph.input_file = input_file;
+    graph.is_csr = is_csr_file(input_file);
+    if (graph.is_csr) return graph.csr.open(input_file) && graph.csr.node_num() <= INT_MAX;
+    return read_gml(input_file, graph.G);
+}
+
+// solve a whole graph and return its number of removed edges, see mps_solve in libmps.cpp
+int solve_graph(const loaded_graph &graph, const mps_options &options) {
+    if (!graph.is_csr) return mps_solve(graph.G, options).removed_edge_num;
+    csr_graph_view view;
+    view.node_num = graph.csr.node_num();
+    view.offset = graph.csr.offsets();
+    view.target = graph.csr.targets();
+    return mps_solve(view, options).removed_edge_num;
+}
+
+
+double seconds_between(std::chrono::high_resolution_clock::time_point start,
+                       std::chrono::high_resolution_clock::time_point end) {
+    auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    return static_cast<double>(microseconds) / 1'000'000.0;
+}
+
+// one line of output: "name, removed edges, time", and the time to read the file if asked for
+void print_result(std::ostream &out, const string &input_file, int removed_edges, double time,
+                  double load_time, bool report_load_time) {
+    string filename = filesystem::path(input_file).stem();
+    out << filename << ", " << removed_edges << ", " << time;
+    if (report_load_time) out << ", " << load_time;
+    out << std::endl;
+}
+
+
+//-----------------------------------------------------------------------------------
+// Batch mode.
+//-----------------------------------------------------------------------------------
+
+// a queue of fixed capacity between two stages of the batch pipeline
+// push waits while it is full, pop waits while it is empty; once closed and drained, pop fails
+template <class T>
+class bounded_queue {
+public:
+    explicit bounded_queue(size_t capacity) : _capacity(capacity) {}
+
+    void push(T item) {
+        unique_lock<mutex> lock(_mutex);
+        _not_full.wait(lock, [this]() { return _items.size() < _capacity; });
+        _items.push_back(std::move(item));
+        _not_empty.notify_one();
+    }
+
+    bool pop(T &item) {
+        unique_lock<mutex> lock(_mutex);
+        _not_empty.wait(lock, [this]() { return !_items.empty() || _closed; });
+        if (_items.empty()) return false;
+        item = std::move(_items.front());
+        _items.pop_front();
+        _not_full.notify_one();
+        return true;
+    }
+
+    void close() {
+        lock_guard<mutex> lock(_mutex);
+        _closed = true;
+        _not_empty.notify_all();
+    }
+
+private:
+    size_t _capacity;
+    deque<T> _items;
+    bool _closed = false;
+    mutex _mutex;
+    condition_variable _not_full;
+    condition_variable _not_empty;
+};
 
-    // prepare random selection
-    std::random_device rd;
-    std::mt19937 gen{rd()}; // seed the generator
+const int BATCH_READERS = 2;
 
-    // variables to manage exponential mutate_index iteration
-    int index_range = best_order.size() - 1; // assumes start from 0
-    int index_start = 0;
-    // given k_max and number of range for mutate_index, we compute growth factor
-    // so that at mutate_factor spans index_range in an exponential rate
-    double growth_factor = std::log(index_range + 1) / (k_max);
-    int mutate_index = 0;
+struct batch_graph {
+    size_t index;
+    bool loaded;
+    double load_time;
+    unique_ptr<loaded_graph> graph;
+};
 
-    for (int r = 0; r < reruns; ++r) {
+struct batch_result {
+    size_t index;
+    string input_file;
+    bool loaded;
+    int removed_edges;
+    double time;
+    double load_time;
+};
 
-        for (int k = 0; k < k_max; ++k) {
-            // update mutate_index based on exponential rate wrt k
-            mutate_index = index_start + static_cast<int>(std::exp(growth_factor * k) - 1);
+// solve every graph listed in list_file, one path per line, prefixed by data_dir if given
+// readers load the graphs ahead of the solvers, jobs solvers take one graph each, and the
+// calling thread writes the results in the order of the list
+// the queues hold at most 2 * jobs graphs and results, so only that many are in memory at once,
+// apart from results that wait for an earlier graph of the list to finish
+// the i-th graph of the list is seeded by substream i of the seed in options
+// returns false if the list or any of its graphs could not be read
+bool solve_batch(const string &list_file, const string &data_dir, const mps_options &options,
+                 bool report_load_time) {
+    int jobs = options.jobs;
+    std::ifstream list(list_file);
+    if (!list) {
+        std::cerr << "Could not read " << list_file << std::endl;
+        return false;
+    }
+    vector<string> input_files;
+    string line;
+    while (std::getline(list, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        input_files.push_back(data_dir.empty() ? line : data_dir + "/" + line);
+    }
 
-            // internally compute_mps already ran a round of guided traversal to rotate the result back
-            // function will return via reference to current_order and new_removed_size
-            compute_mps(G, mutate_index, current_order, new_removed_size);
+    bounded_queue<batch_graph> graphs(2 * jobs);
+    bounded_queue<batch_result> results(2 * jobs);
+    atomic<size_t> next_file{0};
+    atomic<int> readers_left{BATCH_READERS};
+    atomic<int> solvers_left{jobs};
 
+    vector<thread> workers;
+    for (int t = 0; t < BATCH_READERS; ++t) {
+        workers.emplace_back([&]() {
+            for (size_t i = next_file++; i < input_files.size(); i = next_file++) {
+                auto load_start = std::chrono::high_resolution_clock::now();
+                unique_ptr<loaded_graph> graph(new loaded_graph);
+                bool loaded = load_graph(input_files[i], *graph);
+                auto load_end = std::chrono::high_resolution_clock::now();
+                graphs.push(batch_graph{i, loaded, seconds_between(load_start, load_end), std::move(graph)});
+            }
+            if (--readers_left == 0) graphs.close();
+        });
+    }
+    for (int t = 0; t < jobs; ++t) {
+        workers.emplace_back([&]() {
+            batch_graph item;
+            while (graphs.pop(item)) {
+                batch_result result{item.index, item.graph->input_file, item.loaded, 0, 0, item.load_time};
+                if (item.loaded) {
+                    auto start = std::chrono::high_resolution_clock::now();
+                    mps_options graph_options = options;
+                    graph_options.jobs = 1;
+                    graph_options.seed = mutation_rng(options.seed).substream_seed(item.index);
+                    result.removed_edges = solve_graph(*item.graph, graph_options);
+                    auto end = std::chrono::high_resolution_clock::now();
+                    result.time = seconds_between(start, end);
+                }
+                item.graph.reset();
+                results.push(result);
+            }
+            if (--solvers_left == 0) results.close();
+        });
+    }
 
-            // if there is an improvement
-            // 1. update the removed size to use the new smaller size
-            // 2. update the old_order to be the new_order
-            if (new_removed_size < best_removed_size) {
-                best_removed_size = new_removed_size;
-                best_order = current_order;
-            // if there is no improvement, we revert the temp_order to the old_order
+    // results arrive as the solvers finish, they are held back until the ones before are written
+    bool all_loaded = true;
+    map<size_t, batch_result> pending;
+    size_t next_result = 0;
+    batch_result result;
+    while (results.pop(result)) {
+        pending.emplace(result.index, result);
+        for (auto it = pending.find(next_result); it != pending.end(); it = pending.find(++next_result)) {
+            if (it->second.loaded) {
+                print_result(std::cout, it->second.input_file, it->second.removed_edges, it->second.time,
+                             it->second.load_time, report_load_time);
             } else {
-                current_order = best_order;
+                std::cerr << "Could not read " << it->second.input_file << std::endl;
+                all_loaded = false;
             }
+            pending.erase(it);
         }
     }
-    return best_order;
+    for (auto &worker : workers) worker.join();
+    return all_loaded;
 }
 
 
-
 //-----------------------------------------------------------------------------------
 // Main function.
 //-----------------------------------------------------------------------------------
 
 
+// usage: dpt_planarizer [-j jobs] [-i islands] [-l] [-b [-d data_dir]] [--seed seed] input_file k_max reruns
+// the input file is gml, or a CSR file written by graph_processing/gml_to_csr
+// the output is "name, removed edges, time"; with -l the time to read the file is added as a
+// fourth column, it is never part of the third
+// with -j, blocks are solved by jobs threads, largest first, see mps_solve
+// with -i, islands independent searches share their best order, see repeated_mutation_islands
+// with -b, the input file is a list of graphs, which are solved by jobs threads, see solve_batch
+// with --seed, the search is seeded with seed; without it the seed is drawn from
+// std::random_device once
 int main(int argc, char* argv[]) {
-    string input_file = argv[1];
-    int k_max = std::stoi(argv[2]);
-    int reruns = std::stoi(argv[3]);
-
-    ogdf::Graph G = read_from_gml(input_file);
+    int jobs = 1;
+    int islands = 1;
+    bool report_load_time = false;
+    bool batch = false;
+    bool seeded = false;
+    uint64_t seed = 0;
+    string data_dir;
+    vector<string> args;
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) == "-j" && i + 1 < argc) jobs = std::max(1, std::stoi(argv[++i]));
+        else if (string(argv[i]) == "-i" && i + 1 < argc) islands = std::max(1, std::stoi(argv[++i]));
+        else if (string(argv[i]) == "-l") report_load_time = true;
+        else if (string(argv[i]) == "-b") batch = true;
+        else if (string(argv[i]) == "-d" && i + 1 < argc) data_dir = argv[++i];
+        else if (string(argv[i]) == "--seed" && i + 1 < argc) {
+            seed = std::stoull(argv[++i]);
+            seeded = true;
+        }
+        else args.push_back(argv[i]);
+    }
+    if (args.size() < 3) {
+        std::cerr << "usage: " << argv[0] << " [-j jobs] [-i islands] [-l] [-b [-d data_dir]] [--seed seed] input_file k_max reruns" << std::endl;
+        return 1;
+    }
+    string input_file = args[0];
+    if (!seeded) {
+        std::random_device rd;
+        seed = (static_cast<uint64_t>(rd()) << 32) ^ rd();
+    }
+    mps_options options;
+    options.k_max = std::stoi(args[1]);
+    options.reruns = std::stoi(args[2]);
+    options.jobs = jobs;
+    options.islands = islands;
+    options.seed = seed;
+    options.list_removed_edges = false;
 
+    if (batch) {
+        return solve_batch(input_file, data_dir, options, report_load_time) ? 0 : 1;
+    }
 
-    auto start = std::chrono::high_resolution_clock::now();
+    auto load_start = std::chrono::high_resolution_clock::now();
+    loaded_graph graph;
+    if (!load_graph(input_file, graph)) {
+        std::cerr << "Could not read " << input_file << std::endl;
+        return 1;
+    }
+    auto load_end = std::chrono::high_resolution_clock::now();
 
 
-    // lets create graphs of connected components
-    ogdf::List<ogdf::Graph> components;
-    construct_connected_components(G, components);
-    vector<int> post_order;
+    auto start = std::chrono::high_resolution_clock::now();
 
-    int removed_edges = 0;
-    int loop_count = 0;
-    for (auto component:components) {
-        if (component.numberOfEdges() == 0) {
-            continue;
-        }
-        // std::cout << "component: " << loop_count++ << std::endl;
-        // std::cout << component.numberOfNodes() << std::endl;
-        // std::cout << component.numberOfEdges() << std::endl;
-        post_order = repeated_mutation(component, k_max, reruns);
-        removed_edges += compute_removed_edge_size(component, post_order);
-    }
+    int removed_edges = solve_graph(graph, options);
 
     auto end = std::chrono::high_resolution_clock::now();
-    auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
-    double time = static_cast<double>(microseconds) / 1'000'000.0;
 
-   
-    string filename = filesystem::path(input_file).stem();
-    std::cout << filename << ", " << removed_edges << ", " << time << std::endl;
+    print_result(std::cout, input_file, removed_edges, seconds_between(start, end),
+                 seconds_between(load_start, load_end), report_load_time);
 
     // post_order = generate_guided_post_order_iterative(G, post_order);
     // removed_edges = compute_removed_edge_size(G, post_order);
@@ -10,15 +10,12 @@
 maximal_planar_subgraph_finder::maximal_planar_subgraph_finder() {}
 
 //Destructor
-maximal_planar_subgraph_finder::~maximal_planar_subgraph_finder() {
-    for (size_t i = 0; i < _node_list.size(); ++i) delete _node_list[i];
-    for (size_t i = 0; i < _new_node_list.size(); ++i) delete _new_node_list[i];
-}
+//All nodes are owned by _node_pool.
+maximal_planar_subgraph_finder::~maximal_planar_subgraph_finder() {}
 
-node* 
+node_ref 
 maximal_planar_subgraph_finder::get_new_node(node_type t) {
-    _new_node_list.push_back(new node(t));
-    return _new_node_list[_new_node_list.size()-1];
+    return _node_pool.get_new_node(t);
 }
 
 vector<int>
@@ -27,145 +24,185 @@ maximal_planar_subgraph_finder::return_post_order() {
     // we have arg number of elements
     post_order.reserve(_post_order_list.size()); // reserve for decreased reallocation
     for (size_t i = 0; i < _post_order_list.size(); ++i) {
-        post_order.push_back(_post_order_list[i]->node_id());
+        post_order.push_back(node_id(_post_order_list[i]));
     }
     return post_order;
 }
 
-bool 
-maximal_planar_subgraph_finder::sort_by_order(const std::unordered_map<int, int> &node_id_to_pos, node* a, node* b) {
-    auto iter_a = node_id_to_pos.find(a->node_id());
-    auto iter_b = node_id_to_pos.find(b->node_id());
-
-    // second yields the position
-    return iter_a->second < iter_b->second;
-}
-
-// this is very inefficient
-bool 
-maximal_planar_subgraph_finder::sort_by_free_neighbors(node* a, node* b) {
-    int count_a = a->get_unmarked_count();
-    int count_b = b->get_unmarked_count();
-    // count number of unmarked nodes in each node's neighbor list
-    return count_a < count_b;
+// the post_order a guided traversal of the current DFS-tree would return
+// guided by a post_order, the traversal takes the children of a node latest finished first and
+// so rebuilds the same tree with every child list reversed; the post-order of that mirrored tree
+// is the reversed order in which the nodes were reached
+// this holds for a single tree only, the roots of a forest after the first are picked by id,
+// so a forest is traversed again
+vector<int>
+maximal_planar_subgraph_finder::return_oriented_post_order() {
+    int root_num = 0;
+    for (size_t i = 0; i < _post_order_list.size(); ++i) {
+        if (at(_post_order_list[i]).parent() == 0) ++root_num;
+    }
+    if (root_num > 1) {
+        vector<int> temp_order = return_post_order();
+        reset_state();
+        guided_post_order_traversal_iterative(temp_order);
+        return return_post_order();
+    }
+    vector<int> post_order;
+    post_order.reserve(_open_order.size());
+    for (size_t i = _open_order.size(); i-- > 0; ) {
+        post_order.push_back(node_id(_open_order[i]));
+    }
+    return post_order;
 }
 
-// ---- for main to find connected components
-
+// ---- iterative DFS shared by all traversals
+
+//Every traversal below runs on this kernel. The stack holds one frame per node on the
+//current DFS path: the node and a cursor into its neighbor row, so the auxiliary memory is
+//O(n) and no neighbor list is copied per visit. The marks, which are reset once per
+//evaluation, are the visited set shared by all roots. A node gets its post-order-index
+//when its frame is popped, i.e. after its last neighbor has been scanned, which yields
+//the same post-order as pushing every unmarked neighbor in reverse onto a node stack.
+//
+//The neighbor order is a compile-time policy, so each instantiation is a loop without
+//per-node mode checks. The kernel returns early, with the path left on _dfs_stack, once
+//traversal_index reaches open_limit; the caller can then resume it with another policy.
+template <class order_policy>
 void
-maximal_planar_subgraph_finder::dfs_cc(node* root_node, vector<node*> &return_node_list) {
-    // mark all vertices as not visited
-    vector<bool> in_post_order(_node_list.size(), false);
-
-    // create stack for DFS
-    stack<node*> stack;
-
-    // push the current root node into the stack
-    stack.push(root_node);
-
-    while (!stack.empty()) {
-        // pop node from stack
-        node* current_node = stack.top();
-        // std::cout << "1 top: " << current_node->node_id() << '\n';
-
-
-        // stack may contain same vertex twice
-        // print the popped item only if it is not visited
-        // proceed if current node is not markd
-        if (!current_node->is_marked()) {
-            current_node->mark();
-            vector<node*> neighbor_list = current_node->_adj_list;
-            // stack is LIFO - last element in is first to be popped
-            // hence we use a reverse iterator
-            for (auto it = neighbor_list.rbegin(); it != neighbor_list.rend(); ++it) {
-                node* node = (*it);
-                // only add neighbor to stack if it is not visited
-                if (!node->is_marked()) {
-                    // std::cout << "2 add: " << node->node_id() << '\n';
-                    node->set_parent(current_node);
-                    stack.push(node);
-                }
-            }
+maximal_planar_subgraph_finder::dfs_kernel(order_policy order, int &post_order_id, vector<node_ref> &return_node_list,
+                                           int &traversal_index, int open_limit) {
+    while (!_dfs_stack.empty()) {
+        dfs_frame &frame = _dfs_stack.back();
+        // skip neighbors that have been visited since the frame was opened
+        while (frame.next != frame.end && _mark[*frame.next] == MARKED) ++frame.next;
+
+        if (frame.next != frame.end) {
+            if (traversal_index == open_limit) return;
+            // descend into the next unvisited neighbor
+            node_ref child_node = input_node(*frame.next++);
+            at(child_node).set_parent(frame.current_node);
+            open_node(child_node, order, traversal_index);
         } else {
-            // it is possible to see a node again for many times
-            // this section deals with marked nodes that have been added many time
-            // we want to skip nodes that were already added to the output
-            if (in_post_order[current_node->node_id()]) {
-                stack.pop();
-                continue;
-            }
-
-            // here we save the node
-            return_node_list.push_back(current_node);
-            in_post_order[current_node->node_id()] = true;
-            stack.pop();
+            // all neighbors are done, we are going back up the traversed nodes
+            at(frame.current_node).set_post_order_index(post_order_id++);
+            return_node_list.push_back(frame.current_node);
+            _dfs_stack.pop_back();
         }
     }
+}
 
+//Mark a node reached by the traversal and push its frame.
+template <class order_policy>
+void
+maximal_planar_subgraph_finder::open_node(node_ref u, order_policy order, int &traversal_index) {
+    if (order_policy::uses_unmarked_count) mark_counted(u);
+    else mark(u);
+    _open_order.push_back(u);
+    ++traversal_index;
+    _dfs_stack.push_back(dfs_frame{u, 0, 0});
+    row(u, order, _dfs_stack.back().next, _dfs_stack.back().end);
+}
 
+//Input order.
+void
+maximal_planar_subgraph_finder::row(node_ref u, natural_order, const int* &begin, const int* &end) {
+    begin = _adj_target.data() + _adj_offset[node_id(u)];
+    end = _adj_target.data() + _adj_offset[node_id(u) + 1];
+}
 
+//Increasing rank, the rows are sorted by set_rank().
+void
+maximal_planar_subgraph_finder::row(node_ref u, guided_order, const int* &begin, const int* &end) {
+    begin = _ranked_adj_target.data() + _adj_offset[node_id(u)];
+    end = _ranked_adj_target.data() + _adj_offset[node_id(u) + 1];
 }
-// -----
 
+//Biased random order: the row is permuted in place in _mutated_adj_target, starting from input order.
+//
+//The order is built from the back. Position i takes either the element currently held at i
+//(the carry) or one of the remaining elements whose rank by free-neighbor count lies in
+//[i*7/10, i), uniformly. The carry for i-1 is then the remaining element with the most free
+//neighbors. This is what re-sorting the prefix [0, i) before every pick did, at O(d^2 log d)
+//per node. Here the row is sorted once and the remaining elements are kept in a Fenwick tree
+//over their ranks, so a pick is an order-statistic query and a node costs O(d log d).
+//Ranks of equal counts are broken by input position; for distinct counts the resulting
+//order is the one of the re-sorting version for the same random draws.
+void
+maximal_planar_subgraph_finder::row(node_ref u, mutated_order order, const int* &begin, const int* &end) {
+    int row_begin = _adj_offset[node_id(u)];
+    int size = _adj_offset[node_id(u) + 1] - row_begin;
+    int* neighbor_list = _mutated_adj_target.data() + row_begin;
+    begin = neighbor_list;
+    end = neighbor_list + size;
+    if (size == 0) return;
+
+    // rank every neighbor by (free neighbor count, input position)
+    _selector_keys.clear();
+    for (int k = 0; k < size; ++k) {
+        int id = _adj_target[row_begin + k];
+        _selector_keys.push_back(pair<int, int>(_unmarked_count[id], k));
+    }
+    std::sort(_selector_keys.begin(), _selector_keys.end());
+    _selector_rank.resize(size);
+    for (int r = 0; r < size; ++r) _selector_rank[_selector_keys[r].second] = r;
+
+    // the element at the last position is the first carry, all others are remaining
+    int carry = _selector_rank[size - 1];
+    _selector_tree.assign(size + 1, 0);
+    for (int r = 0; r < size; ++r) {
+        if (r != carry) selector_add(r, 1);
+    }
 
+    for (int i = size - 1; i >= 0; --i) {
+        int select = order.rng->uniform(i*7/10, i);
+        // select == i keeps the carry, otherwise take the remaining element of rank select
+        int picked = (select == i) ? carry : selector_kth(select);
+        neighbor_list[i] = _adj_target[row_begin + _selector_keys[picked].second];
+        if (i == 0) break;
+        // the remaining element with the most free neighbors becomes the next carry
+        int most_free = selector_kth(i - 1);
+        if (picked == carry) {
+            selector_add(most_free, -1);
+            carry = most_free;
+        } else if (picked == most_free) {
+            selector_add(most_free, -1);
+        } else {
+            selector_add(picked, -1);
+            selector_add(carry, 1);
+            selector_add(most_free, -1);
+            carry = most_free;
+        }
+    }
+}
 
+//Fenwick tree over the ranks of row(mutated_order): add v at rank r.
 void
-maximal_planar_subgraph_finder::dfs(node* root_node, int &post_order_id) {
-    // mark all vertices as not visited
-    vector<bool> in_post_order(_node_list.size(), false);
-
-    // create stack for DFS
-    stack<node*> stack;
-
-    vector<node*> local_post_order_list;
-    // push the current root node into the stack
-    stack.push(root_node);
-
-    while (!stack.empty()) {
-        // pop node from stack
-        node* current_node = stack.top();
-        // std::cout << "1 top: " << current_node->node_id() << '\n';
-
-
-        // stack may contain same vertex twice
-        // print the popped item only if it is not visited
-        // proceed if current node is not markd
-        if (!current_node->is_marked()) {
-            current_node->mark();
-            vector<node*> neighbor_list = current_node->_adj_list;
-            // stack is LIFO - last element in is first to be popped
-            // hence we use a reverse iterator
-            for (auto it = neighbor_list.rbegin(); it != neighbor_list.rend(); ++it) {
-                node* node = (*it);
-                // only add neighbor to stack if it is not visited
-                if (!node->is_marked()) {
-                    // std::cout << "2 add: " << node->node_id() << '\n';
-                    node->set_parent(current_node);
-                    stack.push(node);
-                }
-            }
-        } else {
-            // it is possible to see a node again for many times
-            // this section deals with marked nodes that have been added many time
-            // we want to skip nodes that were already added to the output
-            if (in_post_order[current_node->node_id()]) {
-                stack.pop();
-                continue;
-            }
+maximal_planar_subgraph_finder::selector_add(int r, int v) {
+    for (int x = r + 1; x < static_cast<int>(_selector_tree.size()); x += x & -x) _selector_tree[x] += v;
+}
 
-            // seeing it again for the first time means that we have ran out of next neighbors
-            // it is going back up the traversed nodes
-            // std::cout << "3 pop: " << current_node->node_id() << '\n';
-            current_node->set_post_order_index(post_order_id++);
-            local_post_order_list.push_back(current_node);
-            in_post_order[current_node->node_id()] = true;
-            stack.pop();
+//Rank of the k-th (from 0) remaining element.
+int
+maximal_planar_subgraph_finder::selector_kth(int k) {
+    int n = _selector_tree.size() - 1;
+    int pos = 0;
+    int step = 1;
+    while (step * 2 <= n) step *= 2;
+    for (; step > 0; step >>= 1) {
+        if (pos + step <= n && _selector_tree[pos + step] <= k) {
+            pos += step;
+            k -= _selector_tree[pos];
         }
     }
-
-    _post_order_list.insert(_post_order_list.end(), local_post_order_list.begin(), local_post_order_list.end());
+    return pos;
+}
 
 
+void
+maximal_planar_subgraph_finder::dfs(node_ref root_node, int &post_order_id) {
+    int traversal_index = 0;
+    open_node(root_node, natural_order(), traversal_index);
+    dfs_kernel(natural_order(), post_order_id, _post_order_list, traversal_index, INT_MAX);
 }
 
 void 
@@ -173,79 +210,20 @@ maximal_planar_subgraph_finder::post_order_traversal_iterative() {
     // node::init_mark();
     int post_order_id = 0;
     // we need to iterate through nodes in case graph is disconnected
-    for (size_t i = 0; i < _node_list.size(); ++i) {
-        if (!_node_list[i]->is_marked()) {
+    for (int i = 0; i < _node_num; ++i) {
+        if (!is_marked(input_node(i))) {
             // set this node at i to be the root node of a new DFS tree
-            dfs(_node_list[i], post_order_id);
+            dfs(input_node(i), post_order_id);
         }
     }
 
 }
 
 void
-maximal_planar_subgraph_finder::dfs_guided(node* root_node, int &post_order_id, const unordered_map<int, int> &node_id_to_pos) {
-    // mark all vertices as not visited
-    vector<bool> in_post_order(_node_list.size(), false);
-
-    // create stack for DFS
-    stack<node*> stack;
-
-    vector<node*> local_post_order_list;
-    // push the current root node into the stack
-    stack.push(root_node);
-
-    while (!stack.empty()) {
-        // pop node from stack
-        node* current_node = stack.top();
-
-
-        // stack may contain same vertex twice
-        // print the popped item only if it is not visited
-        // proceed if current node is not markd
-        if (!current_node->is_marked()) {
-            current_node->mark();
-            vector<node*> neighbor_list = current_node->_adj_list;
-            // change order of neighbors here
-            std::sort(neighbor_list.begin(), neighbor_list.end(), [this, &node_id_to_pos](node *a, node *b)
-                        { return sort_by_order(node_id_to_pos, a, b); });
-
-            // purpose of this block: create list of neighbors ordered in the
-            // order they appear in rev_post_order
-            // we want to select neighbors that match the rev_post_order at the
-            // specific traversal_index
-
-
-            // stack is LIFO - last element in is first to be popped
-            // hence we use a reverse iterator
-            for (size_t i = neighbor_list.size() - 1; i != std::numeric_limits<size_t>::max(); --i) {
-                node* node = neighbor_list[i];
-                // only add neighbor to stack if it is not visited
-                if (!node->is_marked()) {
-                    node->set_parent(current_node);
-                    stack.push(node);
-                }
-            }
-        } else {
-            // it is possible to see a node again for many times
-            // this section deals with marked nodes that have been added many time
-            // we want to skip nodes that were already added to the output
-            if (in_post_order[current_node->node_id()]) {
-                stack.pop();
-                continue;
-            }
-
-            // seeing it again for the first time means that we have ran out of next neighbors
-            // it is going back up the traversed nodes
-            // std::cout << "3 pop: " << current_node->node_id() << '\n';
-            current_node->set_post_order_index(post_order_id++);
-            local_post_order_list.push_back(current_node);
-            in_post_order[current_node->node_id()] = true;
-            stack.pop();
-        }
-    }
-
-
-    _post_order_list.insert(_post_order_list.end(), local_post_order_list.begin(), local_post_order_list.end());
+maximal_planar_subgraph_finder::dfs_guided(node_ref root_node, int &post_order_id) {
+    int traversal_index = 0;
+    open_node(root_node, guided_order(), traversal_index);
+    dfs_kernel(guided_order(), post_order_id, _post_order_list, traversal_index, INT_MAX);
 }
 
 
@@ -256,191 +234,106 @@ void
 maximal_planar_subgraph_finder::guided_post_order_traversal_iterative(const vector<int> &post_order) {
     // node::init_mark();
 
-    // use unordered_map to map node_id to position in reversed post_order
-    unordered_map<int, int> node_id_to_pos;
-    node_id_to_pos.reserve(post_order.size());
-    int j = 0;
-    // we flip the post_order vector around
-    for (size_t i = post_order.size() - 1; i != std::numeric_limits<size_t>::max(); --i) {
-        node_id_to_pos[post_order[i]] = j++;
-    }
+    // node ids are dense, so a flat rank array maps node_id to position in reversed post_order
+    set_rank(post_order);
 
     int post_order_id = 0;
-    int end_condition = _node_list.size();
+    int end_condition = _node_num;
     // we start from the end of the post_order, which is the root node
     int start = post_order[post_order.size() - 1];
     int i = start;
 
     // reserve for _post_order_list to decrease reallocation
-    _post_order_list.reserve(_node_list.size());
+    _post_order_list.reserve(_node_num);
 
 
     while (true)
     {
         if (((start > 0) && (i == (start - 1))) || ((start == 0 ) && (i == end_condition - 1)))
         {
-            if (!_node_list[i]->is_marked())
+            if (!is_marked(input_node(i)))
             {
                 // set this node at i to be the root node of a new DFS tree
-                dfs_guided(_node_list[i], post_order_id, node_id_to_pos);
+                dfs_guided(input_node(i), post_order_id);
 
             }
             break;
         }
-        if (!_node_list[i]->is_marked())
+        if (!is_marked(input_node(i)))
         {
-            dfs_guided(_node_list[i], post_order_id, node_id_to_pos);
+            dfs_guided(input_node(i), post_order_id);
         }
         i = (i + 1) % end_condition;
     }
 }
 
 
-void maximal_planar_subgraph_finder::dfs_mutated(node *root_node, int &post_order_id,
-                                                 const unordered_map<int, int> &node_id_to_pos,
+void maximal_planar_subgraph_finder::dfs_mutated(node_ref root_node, int &post_order_id,
                                                  int mutate_point,
                                                  int &traversal_index,
-                                                 mt19937 rng) {
-
+                                                 mutation_rng &rng) {
     // traversal index tracks how many nodes we have moved in the tree
-    // mark all vertices as not visited
-    vector<bool> in_post_order(_node_list.size(), false);
-    vector<node*> local_post_order_list;
-
-    // create stack for DFS
-    stack<node*> stack;
-
-    // push the current root node into the stack
-    stack.push(root_node);
-
-    while (!stack.empty()) {
-        // pop node from stack
-        node* current_node = stack.top();
-
-
-        // stack may contain same vertex twice
-        // print the popped item only if it is not visited
-        // proceed if current node is not markd
-        if (!current_node->is_marked()) {
-            current_node->mark();
-            vector<node*> neighbor_list = current_node->_adj_list;
-            // change order of neighbors here
-            // purpose of this block: create list of neighbors ordered in the
-            // order they appear in rev_post_order
-            // we want to select neighbors that match the rev_post_order at the
-            // specific traversal_index
-
-            // if the current index comes before mutate point, we do guided traversal
-            if (traversal_index < mutate_point) {
-                std::sort(neighbor_list.begin(), neighbor_list.end(), [this, &node_id_to_pos](node *a, node *b)
-                        { return sort_by_order(node_id_to_pos, a, b); });
-            }
-
-            // increment traversal index when encountering a node for first time
-            traversal_index++;
-
-            // stack is LIFO - last element in is first to be popped
-            // hence we use a reverse iterator
-
-            for (size_t i = neighbor_list.size() - 1; i != std::numeric_limits<size_t>::max(); --i) {
-                if (traversal_index - 1 >= mutate_point) { // undo the earlier increment
-                    std::sort(neighbor_list.begin(), neighbor_list.begin() + i, [this](node *a, node *b)
-                            { return sort_by_free_neighbors(a, b); });
-                    // we shuffle the section close to the index
-                    // std::shuffle(neighbor_list.begin() + (i * 7/10), neighbor_list.begin() + i, rng);
-                    // rather than shuffle, we swap the node at i and some position between i*7/10 and i
-                    std::uniform_int_distribution<size_t> dist(i*7/10, i);
-                    size_t select = dist(rng);
-                    node* temp_node = neighbor_list[i];
-                    neighbor_list[i] = neighbor_list[select];
-                    neighbor_list[select] = temp_node;
-                }
-                node* node = neighbor_list[i];
-                // only add neighbor to stack if it is not visited
-                if (!node->is_marked()) {
-                    node->set_parent(current_node);
-                    stack.push(node);
-                }
-            }
-        } else {
-            // it is possible to see a node again for many times
-            // this section deals with marked nodes that have been added many time
-            // we want to skip nodes that were already added to the output
-            if (in_post_order[current_node->node_id()]) {
-                stack.pop();
-                continue;
-            }
-
-            // seeing it again for the first time means that we have ran out of next neighbors
-            // it is going back up the traversed nodes
-            // std::cout << "3 pop: " << current_node->node_id() << '\n';
-            current_node->set_post_order_index(post_order_id++);
-            local_post_order_list.push_back(current_node);
-            in_post_order[current_node->node_id()] = true;
-            stack.pop();
-        }
+    // nodes opened before the mutate point follow the guided order, the rest the mutated one
+    if (traversal_index < mutate_point) {
+        open_node(root_node, guided_order(), traversal_index);
+        dfs_kernel(guided_order(), post_order_id, _post_order_list, traversal_index, mutate_point);
+        if (_dfs_stack.empty()) return;
+        if (!_unmarked_counts_valid) init_unmarked_counts();
+    } else {
+        if (!_unmarked_counts_valid) init_unmarked_counts();
+        open_node(root_node, mutated_order{&rng}, traversal_index);
     }
-    _post_order_list.insert(_post_order_list.end(), local_post_order_list.begin(), local_post_order_list.end());
+    // resume the path left by the guided kernel, if any, with the mutated order
+    dfs_kernel(mutated_order{&rng}, post_order_id, _post_order_list, traversal_index, INT_MAX);
 }
 
 //Determine the post-order-list by a DFS-traversal.
 // take in a post-order argument then traces the graph in the same order
 // return is by reference via _post_order_list
 void maximal_planar_subgraph_finder::mutated_post_order_traversal_iterative(const vector<int> &post_order,
-                                                                            int mutate_point) {
+                                                                            int mutate_point,
+                                                                            mutation_rng &rng) {
     // node::init_mark();
 
-    // implementation: use unordered_map to map node_id to position in reversed post_order
-    unordered_map<int, int> node_id_to_pos;
-    node_id_to_pos.reserve(post_order.size());
-    int j = 0;
-    // we flip the post_order vector around
-    for (size_t i = post_order.size() - 1; i != std::numeric_limits<size_t>::max(); --i) {
-        node_id_to_pos[post_order[i]] = j++;
-    }
+    // map node_id to position in reversed post_order
+    set_rank(post_order);
 
     int post_order_id = 0;
     int traversal_index = 0;
 
-    // setup random rng function
-    std::random_device rd;
-    std::mt19937 rng{rd()};
-
-
     int start = 0;
     // if we mutate first node, we will select a random starting node
     if (mutate_point == 0) {
         int first_value = 0;
         int last_value = post_order.size() - 1;  
-        std::uniform_int_distribution<> dist{first_value, last_value}; 
-        start = post_order[dist(rng)];
+        start = post_order[rng.uniform(first_value, last_value)];
     // if we don't mutate first, we just use the root node of the post_order
     } else {
         start = post_order[post_order.size() - 1];
     }
 
     // reserve for _post_order_list to decrease reallocation
-    _post_order_list.reserve(_node_list.size());
+    _post_order_list.reserve(_node_num);
 
     // set loop variables
     int i = start;
-    int end_condition = _node_list.size();
+    int end_condition = _node_num;
     // this loop assumes start is not from 0
     // if starting index is not 0, it just increments and loops around until it encounters the element before it
     while (true)
     {
         if (((start > 0) && (i == (start - 1))) || ((start == 0 ) && (i == end_condition - 1)))
         {
-            if (!_node_list[i]->is_marked())
+            if (!is_marked(input_node(i)))
             {
-                dfs_mutated(_node_list[i], post_order_id, node_id_to_pos,
+                dfs_mutated(input_node(i), post_order_id,
                             mutate_point, traversal_index, rng);
             }
             break;
         }
-        if (!_node_list[i]->is_marked())
+        if (!is_marked(input_node(i)))
         {
-            dfs_mutated(_node_list[i], post_order_id, node_id_to_pos,
+            dfs_mutated(input_node(i), post_order_id,
                         mutate_point, traversal_index, rng);
 
         }
@@ -455,9 +348,9 @@ maximal_planar_subgraph_finder::print_post_order() {
     int current_index;
     int parent_index;
     for (size_t i = 0; i < _post_order_list.size(); ++i) {
-        current_index = _post_order_list[i]->node_id();
-        if (_post_order_list[i]->parent() != nullptr) {
-            parent_index =_post_order_list[i]->post_order_index();
+        current_index = node_id(_post_order_list[i]);
+        if (at(_post_order_list[i]).parent() != 0) {
+            parent_index =at(_post_order_list[i]).post_order_index();
         }
         std::cout << "(" << current_index << ", " << parent_index << ")"  << ",";
     }
@@ -470,8 +363,8 @@ maximal_planar_subgraph_finder::print_edge_list() {
     int current_index;
     int parent_index;
     for (size_t i = 0; i < _edge_list.size(); ++i) {
-        int first = _edge_list[i].first->node_id();
-        int second = _edge_list[i].second->node_id();
+        int first = node_id(_edge_list[i].first);
+        int second = node_id(_edge_list[i].second);
                 std::cout << "(" << first << ", " << second << ")"  << ",";
     }
     std::cout << std::endl;
@@ -479,18 +372,104 @@ maximal_planar_subgraph_finder::print_edge_list() {
 
 
 
+int
+maximal_planar_subgraph_finder::degree(node_ref u) {
+    return _adj_offset[node_id(u) + 1] - _adj_offset[node_id(u)];
+}
+
+// rank[id] = position of node id in the reversed post_order
+// also counting-sort every input row by rank into _ranked_adj_target, which is the order
+// in which a guided traversal tries the neighbors
+void
+maximal_planar_subgraph_finder::set_rank(const vector<int> &post_order) {
+    _rank.resize(_node_num);
+    int j = 0;
+    // we flip the post_order vector around
+    for (size_t i = post_order.size() - 1; i != std::numeric_limits<size_t>::max(); --i) {
+        _rank[post_order[i]] = j++;
+    }
+
+    _ranked_adj_target.resize(_adj_target.size());
+    _mutated_adj_target.resize(_adj_target.size());
+    _adj_fill.assign(_adj_offset.begin(), _adj_offset.end() - 1);
+    for (size_t i = post_order.size() - 1; i != std::numeric_limits<size_t>::max(); --i) {
+        int row = post_order[i];
+        for (int k = _adj_offset[row]; k < _adj_offset[row + 1]; ++k) {
+            _ranked_adj_target[_adj_fill[_adj_target[k]]++] = row;
+        }
+    }
+}
+
+// u is an input node
+bool
+maximal_planar_subgraph_finder::is_marked(node_ref u) {
+    return _mark[node_id(u)] == MARKED;
+}
+
+void
+maximal_planar_subgraph_finder::mark(node_ref u) {
+    _mark[node_id(u)] = MARKED;
+}
+
+// mark u and keep the unmarked-neighbor counts of its neighbors up to date
+// only used once init_unmarked_counts() has run, other traversals just call mark()
+void
+maximal_planar_subgraph_finder::mark_counted(node_ref u) {
+    mark(u);
+    for (int k = _adj_offset[node_id(u)]; k < _adj_offset[node_id(u) + 1]; ++k) {
+        _unmarked_count[_adj_target[k]]--;
+    }
+}
+
+// set every unmarked-neighbor count from the current marks
+// only the mutated order reads the counts, so instead of having every traversal pay a
+// scattered write per edge on each mark, they are computed once when a traversal reaches
+// its mutate point, and maintained by mark_counted() from there on
+void
+maximal_planar_subgraph_finder::init_unmarked_counts() {
+    _unmarked_count.resize(_node_num);
+    for (int i = 0; i < _node_num; ++i) {
+        _unmarked_count[i] = _adj_offset[i + 1] - _adj_offset[i];
+    }
+    for (int i = 0; i < _node_num; ++i) {
+        if (_mark[i] != MARKED) continue;
+        for (int k = _adj_offset[i]; k < _adj_offset[i + 1]; ++k) {
+            _unmarked_count[_adj_target[k]]--;
+        }
+    }
+    _unmarked_counts_valid = true;
+}
+
 //Sort the adj-list of every node increasingly according to post-order-index.
+//Counting sort into _sorted_adj_target: visiting the nodes in post-order and appending
+//each one to its neighbors' rows yields every row already sorted.
 void
 maximal_planar_subgraph_finder::sort_adj_list() {
-    vector<vector<node*> > vecList;
-    vecList.resize(_post_order_list.size());
-    for (size_t i = 0; i < _post_order_list.size(); ++i) {
-        for (int j = 0; j < _post_order_list[i]->degree(); ++j) {
-            vecList[_post_order_list[i]->adj(j)->post_order_index()].push_back(_post_order_list[i]);
+    size_t n = _post_order_list.size();
+    _sorted_adj_offset.resize(n + 1);
+    _sorted_adj_offset[0] = 0;
+    for (size_t i = 0; i < n; ++i) {
+        _sorted_adj_offset[i + 1] = _sorted_adj_offset[i] + degree(_post_order_list[i]);
+    }
+    _sorted_adj_target.resize(_sorted_adj_offset[n]);
+    _adj_fill.assign(_sorted_adj_offset.begin(), _sorted_adj_offset.end() - 1);
+    for (size_t i = 0; i < n; ++i) {
+        int row = node_id(_post_order_list[i]);
+        for (int k = _adj_offset[row]; k < _adj_offset[row + 1]; ++k) {
+            int neighbor_index = at(input_node(_adj_target[k])).post_order_index();
+            _sorted_adj_target[_adj_fill[neighbor_index]++] = i;
         }
     }
-    for (size_t i = 0; i < _post_order_list.size(); ++i) {
-        _post_order_list[i]->set_adj_list(vecList[i]);
+    if (_adj_weight.empty()) return;
+    // the weights follow their entries
+    _sorted_adj_weight.resize(_sorted_adj_offset[n]);
+    _adj_fill.assign(_sorted_adj_offset.begin(), _sorted_adj_offset.end() - 1);
+    for (size_t i = 0; i < n; ++i) {
+        int row = node_id(_post_order_list[i]);
+        for (int k = _adj_offset[row]; k < _adj_offset[row + 1]; ++k) {
+            int neighbor_index = at(input_node(_adj_target[k])).post_order_index();
+            _sorted_adj_weight[_adj_fill[neighbor_index]++] = _adj_weight[k];
+        }
     }
 }
 
@@ -500,92 +479,119 @@ void
 maximal_planar_subgraph_finder::determine_edges() {
     for (size_t i = 0; i < _post_order_list.size(); ++i) {
         // if there is no parent, then just ignore the node
-        if (_post_order_list[i]->parent() == nullptr) continue;
-        _post_order_list[i]->set_1st_label(_post_order_list[i]->parent()->post_order_index());
-        _edge_list.push_back(pair<node*, node*> (_post_order_list[i]->parent(), _post_order_list[i]));
+        if (at(_post_order_list[i]).parent() == 0) continue;
+        at(_post_order_list[i]).set_1st_label(at(at(_post_order_list[i]).parent()).post_order_index());
+        _edge_list.push_back(pair<node_ref, node_ref> (at(_post_order_list[i]).parent(), _post_order_list[i]));
     }
     for (size_t i = 0; i < _post_order_list.size(); ++i) {
-        for (int j = 0; j < _post_order_list[i]->degree(); ++j) {
+        for (int j = _sorted_adj_offset[i]; j < _sorted_adj_offset[i + 1]; ++j) {
             // this ensures that added edges are indeed back edges
             // position in the _post_order_list is from leaf to root
             // the node is the child, the adj is the ancestor
             // the id in the _post_order_list of child must be lesser than the ancestor
-            if (_post_order_list[i]->adj(j)->post_order_index() > static_cast<int>(i)) break;
+            if (_sorted_adj_target[j] > static_cast<int>(i)) break;
+            node_ref adj_node = _post_order_list[_sorted_adj_target[j]];
             // if the child points to an immediate parent, then also ignore it
-            if (_post_order_list[i]->adj(j)->get_1st_label() == static_cast<int>(i)) continue;
-            _back_edge_list.push_back(pair<node*, node*> (_post_order_list[i], _post_order_list[i]->adj(j)));
+            if (at(adj_node).get_1st_label() == static_cast<int>(i)) continue;
+            _back_edge_list.push_back(pair<node_ref, node_ref> (_post_order_list[i], adj_node));
+            if (!_adj_weight.empty()) _back_edge_weight.push_back(_sorted_adj_weight[j]);
             _is_back_edge_eliminate.push_back(false);
         }
     }
     for (size_t i = 0; i < _post_order_list.size(); ++i) {
-        _post_order_list[i]->set_1st_label(INT_MAX);
+        at(_post_order_list[i]).set_1st_label(INT_MAX);
     }
 }
 
 //The main part of the whole algorithm: Back-edge-traversal
-void 
-maximal_planar_subgraph_finder::back_edge_traversal() {
-    node* i_node = 0;
-    node* current_node = 0;
+//It stops once cutoff back-edges are eliminated and returns false, the state is then
+//incomplete until the next reset_state().
+bool 
+maximal_planar_subgraph_finder::back_edge_traversal(int cutoff) {
+    node_ref i_node = 0;
+    node_ref current_node = 0;
     for (size_t i = 0; i < _back_edge_list.size(); ++i) {
         current_node = _back_edge_list[i].second;
         i_node = _back_edge_list[i].first;
-        if (!back_edge_traversal(current_node, i_node->post_order_index())) _is_back_edge_eliminate[i] = true;
+        if (!back_edge_traversal(current_node, at(i_node).post_order_index())) {
+            _is_back_edge_eliminate[i] = true;
+            _eliminated_num += back_edge_weight(i);
+            if (_eliminated_num >= cutoff) return false;
+        }
     }
+    return true;
 }
 
 //sub-function for the for-loop of back_edge_traversal().
-bool maximal_planar_subgraph_finder::back_edge_traversal(node* traverse_node, int index) {
-    node* parent_node; //The next node to traverse.
-    //If the node has been deleted. 
-    if (traverse_node == 0 || traverse_node->get_2nd_label() == DELETED) {
-        return false;
-    }
-    //We have reached the i-node, stop.
-    if (traverse_node->post_order_index() == index) {
-        return true;
-    }
-    //Case 1
-    if (traverse_node->get_2nd_label() == NOT_VISITED) {
-        //1.1
-        if (traverse_node->get_1st_label() == INT_MAX) {
-            traverse_node->set_1st_label(index);
-            parent_node = traverse_node->parent();
+//Walks up from traverse_node towards the i-node (post-order-index == index).
+//Each step only decides the next node to traverse, so the walk is a loop that records the
+//(traverse_node, parent_node) steps in _traversal_path. Once the walk reaches the i-node or a
+//deleted node, the steps are unwound from the top: on success every node is added to the
+//children of its next node, otherwise every node on the path is eliminated.
+bool maximal_planar_subgraph_finder::back_edge_traversal(node_ref traverse_node, int index) {
+    bool reached = false;
+    _traversal_path.clear();
+    while (true) {
+        node_ref parent_node = 0; //The next node to traverse.
+        //If the node has been deleted. 
+        if (traverse_node == 0 || at(traverse_node).get_2nd_label() == DELETED) {
+            reached = false;
+            break;
         }
-        //1.2
-        else if (traverse_node->get_1st_label() == index) {
-            return true;
+        //We have reached the i-node, stop.
+        if (at(traverse_node).post_order_index() == index) {
+            reached = true;
+            break;
+        }
+        //Case 1
+        if (at(traverse_node).get_2nd_label() == NOT_VISITED) {
+            //1.1
+            if (at(traverse_node).get_1st_label() == INT_MAX) {
+                at(traverse_node).set_1st_label(index);
+                parent_node = at(traverse_node).parent();
+            }
+            //1.2
+            else if (at(traverse_node).get_1st_label() == index) {
+                reached = true;
+                break;
+            }
+            //1.3
+            else if (at(traverse_node).get_1st_label() < index) {
+                parent_node = construct(traverse_node);
+                at(traverse_node).set_1st_label(index);
+            }
         }
-        //1.3
-        else if (traverse_node->get_1st_label() < index) {
-            parent_node = construct(traverse_node);
-            traverse_node->set_1st_label(index);
+        //Case 2: Find the top-tier c-node.
+        else {
+            node_ref my_c_node = find(traverse_node);
+            make_essential(traverse_node, my_c_node);
+            //2.1
+            if (at(my_c_node).get_1st_label() == index) {
+                parent_node = my_c_node;
+            }
+            //2.2
+            else if (at(my_c_node).get_1st_label() < index) {
+                node_ref my_c_node_2 = construct(my_c_node, traverse_node);
+                parent_node = my_c_node_2;
+            }
+            at(traverse_node).set_1st_label(index);
+            at(traverse_node).set_2nd_label(NOT_VISITED);
         }
+        _traversal_path.push_back(pair<node_ref, node_ref>(traverse_node, parent_node));
+        traverse_node = parent_node;
     }
-    //Case 2: Find the top-tier c-node.
-    else {
-        node* my_c_node = find(traverse_node);
-        make_essential(traverse_node, my_c_node);
-        //2.1
-        if (my_c_node->get_1st_label() == index) {
-            parent_node = my_c_node;
+    //Unwind, the step nearest to the i-node first.
+    for (size_t i = _traversal_path.size() - 1; i != std::numeric_limits<size_t>::max(); --i) {
+        node_ref step_node = _traversal_path[i].first;
+        node_ref parent_node = _traversal_path[i].second;
+        if (reached) {
+            if (parent_node != _post_order_list[index]) add_child(parent_node, step_node);
         }
-        //2.2
-        else if (my_c_node->get_1st_label() < index) {
-            node* my_c_node_2 = construct(my_c_node, traverse_node);
-            parent_node = my_c_node_2;
+        else {
+            eliminate(step_node);
         }
-        traverse_node->set_1st_label(index);
-        traverse_node->set_2nd_label(NOT_VISITED);
-    }
-    if (back_edge_traversal(parent_node, index)) {
-        if (parent_node != _post_order_list[index]) parent_node->add_child(traverse_node);
-        return true;
-    }
-    else {
-        eliminate(traverse_node);
-        return false;
     }
+    return reached;
 }
 
 //The p_node is originally a normal node in c_node's boundary cycle.
@@ -594,73 +600,85 @@ bool maximal_planar_subgraph_finder::back_edge_traversal(node* traverse_node, in
 //2. Take out the p_node from c_node, and then set the parent of p_node to be c_node.
 //Note: We are not adding p_node to the c_node's children-list.
 void 
-maximal_planar_subgraph_finder::make_essential(node* p_node, node* c_node) {
-    node* sentinel = get_new_node(REPLICA_NODE);
-    node* n0 = p_node->neighbor(0);
-    node* n1 = p_node->neighbor(1);
-    sentinel->init_replica(p_node, c_node);
-    c_node->add_essential(sentinel);
-    sentinel->set_to_boundary_path(n0, n1);
-    sentinel->inherit_AE(p_node);
-    n0->set_neighbor(n0->get_next(p_node), sentinel);
-    n1->set_neighbor(n1->get_next(p_node), sentinel);
-    p_node->set_neighbor((node*)0, (node*)0);
-    p_node->set_parent(c_node);
+maximal_planar_subgraph_finder::make_essential(node_ref p_node, node_ref c_node) {
+    node_ref sentinel = get_new_node(REPLICA_NODE);
+    node_ref n0 = at(p_node).neighbor(0);
+    node_ref n1 = at(p_node).neighbor(1);
+    init_replica(sentinel, p_node, c_node);
+    add_essential(c_node, sentinel);
+    at(sentinel).set_to_boundary_path(n0, n1);
+    inherit_AE(sentinel, p_node);
+    at(n0).set_neighbor(at(n0).get_next(p_node), sentinel);
+    at(n1).set_neighbor(at(n1).get_next(p_node), sentinel);
+    at(p_node).set_neighbor((node_ref)0, (node_ref)0);
+    at(p_node).set_parent(c_node);
 }
 
 //Find the top-tier c-node of the input node.
 //Note: We don't set the input node to be essential node of the top-tier c-node.
 //When terminated, the input node will be in the boundary cycle of top-tier c-node.
-node* maximal_planar_subgraph_finder::find(node* n) {
-    pair<pair<node*, node*>, pair<node*, node*> > boundary;
-    node* c_node_new = 0;
-    int c_node_size = 0;
-    node* return_node = 0;
-    if (n->parent() == 0) {
-        //If n is already a node in boundary cycle.
-        //Note: n must not be an essential node, otherwise it will never enter the function.
-        //Find the first(nearest to n) essential node.
-        boundary.first = parallel_search_sentinel(n, c_node_new);
-    }
-    else {
-        //If n is not a node in boundary cycle.
-        //It is in an Artificial edge.
-        //Trim it.
-        boundary = trim(n);
-        //Find the first(nearest to n) essential node.
-        boundary.first = parallel_search_sentinel(boundary.first.first, boundary.first.second, boundary.second.first, boundary.second.second, c_node_new);
-    }
-    //Find the c-node in the current hierachy .
-    //If it is top-tier, return it.
-    if (c_node_new != 0) return c_node_new;
-    c_node_new = (boundary.first).first->get_c_node();
-       
-    //If not, find the two nearest essential node, eliminate the rest nodes.
-    c_node_size = c_node_new->c_node_size();
-    boundary.second = count_sentinel_elimination(boundary.first, c_node_size);
-    //Go to the higher hierachy, and continue to find.
-    if (c_node_new->get_2nd_label() == ARTIFICIAL_EDGE) {
-        //A peculiar technic: 
-        //Remove all the children of c_node_new but the one that should remains(Let it be u).
-        //Remove all other essential nodes, pretend to be a c-node of size equals 2.
-        //Call find(u).
-        node* u = 0;
-        for (int i = 0; i < c_node_new->child_num(); ++i) {
-            if (node::is_same(boundary.first.first, c_node_new->child(i)) || node::is_same(boundary.second.first, c_node_new->child(i))) {
-                u = c_node_new->child(i);
+//Each hierarchy climbed leaves a (boundary, c-node) pair on _find_stack; the merges into
+//the higher hierarchy are done once the top-tier c-node is known, from the highest down.
+node_ref maximal_planar_subgraph_finder::find(node_ref n) {
+    size_t stack_base = _find_stack.size();
+    node_ref return_node = 0;
+    while (true) {
+        pair<pair<node_ref, node_ref>, pair<node_ref, node_ref> > boundary;
+        node_ref c_node_new = 0;
+        int c_node_size = 0;
+        if (at(n).parent() == 0) {
+            //If n is already a node in boundary cycle.
+            //Note: n must not be an essential node, otherwise it will never enter the function.
+            //Find the first(nearest to n) essential node.
+            boundary.first = parallel_search_sentinel(n, c_node_new);
+        }
+        else {
+            //If n is not a node in boundary cycle.
+            //It is in an Artificial edge.
+            //Trim it.
+            boundary = trim(n);
+            //Find the first(nearest to n) essential node.
+            boundary.first = parallel_search_sentinel(boundary.first.first, boundary.first.second, boundary.second.first, boundary.second.second, c_node_new);
+        }
+        //Find the c-node in the current hierachy .
+        //If it is top-tier, return it.
+        if (c_node_new != 0) {
+            return_node = c_node_new;
+            break;
+        }
+        c_node_new = at((boundary.first).first).get_c_node();
+           
+        //If not, find the two nearest essential node, eliminate the rest nodes.
+        c_node_size = at(c_node_new).c_node_size();
+        boundary.second = count_sentinel_elimination(boundary.first, c_node_size);
+        //Go to the higher hierachy, and continue to find.
+        if (at(c_node_new).get_2nd_label() == ARTIFICIAL_EDGE) {
+            //A peculiar technic: 
+            //Remove all the children of c_node_new but the one that should remains(Let it be u).
+            //Remove all other essential nodes, pretend to be a c-node of size equals 2.
+            //Continue to find from u.
+            node_ref u = 0;
+            for (int i = 0; i < at(c_node_new).child_num(); ++i) {
+                if (is_same(boundary.first.first, child(c_node_new, i)) || is_same(boundary.second.first, child(c_node_new, i))) {
+                    u = child(c_node_new, i);
+                }
+                else eliminate(child(c_node_new, i));
             }
-            else eliminate(c_node_new->child(i));
+            at(c_node_new).clear_children();
+            add_child(c_node_new, u);
+            at(c_node_new).clear_essential();
+            add_essential(c_node_new, boundary.first.first);
+            add_essential(c_node_new, boundary.second.first);
+            n = u;
         }
-        c_node_new->clear_children();
-        c_node_new->add_child(u);
-        c_node_new->clear_essential();
-        c_node_new->add_essential(boundary.first.first);
-        c_node_new->add_essential(boundary.second.first);
-        return_node = find(u);
+        else n = c_node_new;
+        _find_stack.push_back(make_pair(boundary, c_node_new));
+    }
+    //Merge the part of boundary cycle remains in each hierachy to the top-tier c-node.
+    while (_find_stack.size() > stack_base) {
+        merge(_find_stack.back().first, _find_stack.back().second);
+        _find_stack.pop_back();
     }
-    else return_node = find(c_node_new);
-    //Merge the part of boundary cycle remains in current hierachy to the top-tier c-node.
-    merge(boundary, c_node_new);
     return return_node;
 }
 
@@ -670,12 +688,12 @@ node* maximal_planar_subgraph_finder::find(node* n) {
 //Set list_node to be DELETED.
 //Note: We do not eliminate anything in this function.
 void 
-maximal_planar_subgraph_finder::merge(pair<pair<node*, node*>, pair<node*, node*> > boundary, node* list_node) {
-    node* n0 = list_node->neighbor(0);
-    node* n1 = list_node->neighbor(1);
-    node* s0, * s0_prev;
-    node* s1, * s1_prev;
-    if (node::is_same(boundary.first.first, n0)) {
+maximal_planar_subgraph_finder::merge(pair<pair<node_ref, node_ref>, pair<node_ref, node_ref> > boundary, node_ref list_node) {
+    node_ref n0 = at(list_node).neighbor(0);
+    node_ref n1 = at(list_node).neighbor(1);
+    node_ref s0, s0_prev;
+    node_ref s1, s1_prev;
+    if (is_same(boundary.first.first, n0)) {
         s0 = boundary.first.first;
         s0_prev = boundary.first.second;
         s1 = boundary.second.first;
@@ -688,20 +706,20 @@ maximal_planar_subgraph_finder::merge(pair<pair<node*, node*>, pair<node*, node*
         s1_prev = boundary.first.second;
     }
     if (s0_prev == s1 && s1_prev == s0) {
-        n0->set_neighbor(n0->get_next(list_node), n1);
-        n1->set_neighbor(n1->get_next(list_node), n0);
+        at(n0).set_neighbor(at(n0).get_next(list_node), n1);
+        at(n1).set_neighbor(at(n1).get_next(list_node), n0);
     }
     else {
-        n0->set_neighbor(n0->get_next(list_node), s0_prev);
-        n1->set_neighbor(n1->get_next(list_node), s1_prev);
-        s0_prev->set_neighbor(s0_prev->get_next(s0), n0);
-        s1_prev->set_neighbor(s1_prev->get_next(s1), n1);
+        at(n0).set_neighbor(at(n0).get_next(list_node), s0_prev);
+        at(n1).set_neighbor(at(n1).get_next(list_node), s1_prev);
+        at(s0_prev).set_neighbor(at(s0_prev).get_next(s0), n0);
+        at(s1_prev).set_neighbor(at(s1_prev).get_next(s1), n1);
     }
     //Inherit AE.
-    n0->inherit_AE(s0);
-    n1->inherit_AE(s1);
+    inherit_AE(n0, s0);
+    inherit_AE(n1, s1);
     //Delete c-node
-    list_node->set_2nd_label(DELETED);
+    at(list_node).set_2nd_label(DELETED);
 }
 
 //Set u and its subtree to be DELETED.
@@ -709,47 +727,57 @@ maximal_planar_subgraph_finder::merge(pair<pair<node*, node*>, pair<node*, node*
 //We don't do anything about u's parent, neighborhood.(Only children are affected.)
 //If u is a p-node, we don't eliminate anything in the lower hierachy that corresponds to the same p-node.
 //If u is a c-node, we eliminate all nodes in u's boundary cycle.
+//Nodes still to be eliminated are kept on _eliminate_stack; eliminating only sets labels,
+//so the nodes that end up DELETED do not depend on the order they are taken from the stack.
 void 
-maximal_planar_subgraph_finder::eliminate(node* u) {
-    if (u->get_2nd_label() == DELETED) return;
-       u->set_2nd_label(DELETED);
-    if (u->type() == C_NODE) {
-        node* list_node = u->get_a_list_node();
-        node* n0, * n0_prev;;
-        node* temp = 0;
-        n0 = list_node;
-        n0_prev = list_node->neighbor(0);
-        while (true) {
-            eliminate(n0);
-            temp = n0;
-            n0 = n0->get_next(n0_prev);
-            n0_prev = temp;
-            if (n0 == list_node) break;
+maximal_planar_subgraph_finder::eliminate(node_ref u) {
+    size_t stack_base = _eliminate_stack.size();
+    _eliminate_stack.push_back(u);
+    while (_eliminate_stack.size() > stack_base) {
+        u = _eliminate_stack.back();
+        _eliminate_stack.pop_back();
+        if (at(u).get_2nd_label() == DELETED) continue;
+           at(u).set_2nd_label(DELETED);
+        if (at(u).type() == C_NODE) {
+            node_ref list_node = get_a_list_node(u);
+            node_ref n0, n0_prev;;
+            node_ref temp = 0;
+            n0 = list_node;
+            n0_prev = at(list_node).neighbor(0);
+            while (true) {
+                _eliminate_stack.push_back(n0);
+                temp = n0;
+                n0 = at(n0).get_next(n0_prev);
+                n0_prev = temp;
+                if (n0 == list_node) break;
+            }
         }
-    }
-    else if (u->type() == P_NODE) {
-        for (int i = 0; i < u->degree(); ++i) {
-            if (u->adj(i)->post_order_index() < u->post_order_index() && u->adj(i)->get_1st_label() == INT_MAX) eliminate(u->adj(i));
+        else if (at(u).type() == P_NODE) {
+            int row = at(u).post_order_index();
+            for (int k = _sorted_adj_offset[row]; k < _sorted_adj_offset[row + 1]; ++k) {
+                node_ref adj_node = _post_order_list[_sorted_adj_target[k]];
+                if (_sorted_adj_target[k] < row && at(adj_node).get_1st_label() == INT_MAX) _eliminate_stack.push_back(adj_node);
+            }
+        }
+        if (at(u).AE(0) != 0) _eliminate_stack.push_back(at(u).AE(0));
+        if (at(u).AE(1) != 0) _eliminate_stack.push_back(at(u).AE(1));
+        for (int i = 0; i < at(u).child_num(); ++i) {
+            _eliminate_stack.push_back(child(u, i));
         }
-    }
-    if (u->AE(0) != 0) eliminate(u->AE(0));
-    if (u->AE(1) != 0) eliminate(u->AE(1));
-    for (int i = 0; i < u->child_num(); ++i) {
-        eliminate(u->child(i));
     }
 }
 
 //Eliminate the AE of(u,v)-link that points to u.(If exists)
 void 
-maximal_planar_subgraph_finder::eliminate_AE(node* u, node* v) {
-    int v_index = v->post_order_index();
-    if (u->AE(0) != 0 && u->AE(0)->get_1st_label() == v_index) {
-        eliminate (u->AE(0));
-        u->set_AE(0, 0);
+maximal_planar_subgraph_finder::eliminate_AE(node_ref u, node_ref v) {
+    int v_index = at(v).post_order_index();
+    if (at(u).AE(0) != 0 && at(at(u).AE(0)).get_1st_label() == v_index) {
+        eliminate (at(u).AE(0));
+        set_AE(u, 0, 0);
     }
-    if (u->AE(1) != 0 && u->AE(1)->get_1st_label() == v_index) {
-        eliminate (u->AE(1));
-        u->set_AE(1, 0);
+    if (at(u).AE(1) != 0 && at(at(u).AE(1)).get_1st_label() == v_index) {
+        eliminate (at(u).AE(1));
+        set_AE(u, 1, 0);
     }
 }
 
@@ -757,43 +785,44 @@ maximal_planar_subgraph_finder::eliminate_AE(node* u, node* v) {
 //The traversed node is in the AE = (up <- down).
 //The returned boundary = [up, up_prev ..., down_prev, down].
 //Direction: up it higher than down.
-pair<pair<node*, node*>, pair<node*, node*> > 
-maximal_planar_subgraph_finder::trim(node* u) {
-    node* up = 0;
-    node* down = 0;
+pair<pair<node_ref, node_ref>, pair<node_ref, node_ref> > 
+maximal_planar_subgraph_finder::trim(node_ref u) {
+    node_ref up = 0;
+    node_ref down = 0;
     //Since we may do c-node extension in the future, we need to memorize next in order to deduce prev.
-    node* up_next = 0;
-    node* down_next = 0;
-    node* new_AE_root = 0;
+    node_ref up_next = 0;
+    node_ref down_next = 0;
+    node_ref new_AE_root = 0;
     //The index from small to large indicates the path that we traversed, note that u = node_list[0].
-    vector<node*> node_list;
-    node* curr = u;
+    vector<node_ref> &node_list = _trim_path;
+    node_list.clear();
+    node_ref curr = u;
     node_list.push_back(u);
     //Traverse upward.
     while (true) {
-        curr = curr->parent();
-        if (curr->type() == AE_VIRTUAL_ROOT) {
-            up = curr->parent();
+        curr = at(curr).parent();
+        if (at(curr).type() == AE_VIRTUAL_ROOT) {
+            up = at(curr).parent();
             //case 1: We are in a newly created c-node.
             //It has only one AE, and the two neighbor-pointer point to the same one.
-            if (up->neighbor(0) == up->neighbor(1)) {
-                down = up->neighbor(0);
-                up->set_neighbor(down, node_list[node_list.size()-1]);
-                down->set_neighbor(up, node_list[0]);
-                curr->remove_child(node_list[node_list.size()-1]);
+            if (at(up).neighbor(0) == at(up).neighbor(1)) {
+                down = at(up).neighbor(0);
+                at(up).set_neighbor(down, node_list[node_list.size()-1]);
+                at(down).set_neighbor(up, node_list[0]);
+                remove_child(curr, node_list[node_list.size()-1]);
                 //There's no other child, just delete the AE.
-                if (curr->child_num() == 0) {
-                    up->set_AE(0, 0);
-                    up->set_AE(1, 0);
+                if (at(curr).child_num() == 0) {
+                    set_AE(up, 0, 0);
+                    set_AE(up, 1, 0);
                 }
             }
             //case 2: General case.
             else {
-                if (up->neighbor(0)->post_order_index() == curr->get_1st_label()) down = up->neighbor(0);
-                else down = up->neighbor(1);
-                up->set_neighbor(up->get_next(down), node_list[node_list.size()-1]);
-                down->set_neighbor(down->get_next(up), node_list[0]);
-                curr->remove_child(node_list[node_list.size()-1]);
+                if (at(at(up).neighbor(0)).post_order_index() == at(curr).get_1st_label()) down = at(up).neighbor(0);
+                else down = at(up).neighbor(1);
+                at(up).set_neighbor(at(up).get_next(down), node_list[node_list.size()-1]);
+                at(down).set_neighbor(at(down).get_next(up), node_list[0]);
+                remove_child(curr, node_list[node_list.size()-1]);
                 eliminate_AE(up, down);
             }
             break;
@@ -802,31 +831,31 @@ maximal_planar_subgraph_finder::trim(node* u) {
     }
     //Set the "downward" AE of node_list[0].
     new_AE_root = get_new_node(AE_VIRTUAL_ROOT);
-    new_AE_root->init_AE(node_list[0]);
+    init_AE(new_AE_root, node_list[0]);
     //Eliminate the children other than the path.
     for (size_t i = 1; i < node_list.size(); ++i) {
-        for (int j = 0; j < node_list[i]->child_num(); ++j) {
-            if (node_list[i]->child(j) != node_list[i-1]) eliminate(node_list[i]->child(j));
+        for (int j = 0; j < at(node_list[i]).child_num(); ++j) {
+            if (child(node_list[i], j) != node_list[i-1]) eliminate(child(node_list[i], j));
         }
     }
     //Set to the boundary path.
-    if (node_list.size() == 1) node_list[0]->set_to_boundary_path(up, down);
+    if (node_list.size() == 1) at(node_list[0]).set_to_boundary_path(up, down);
     else {
-        node_list[0]->set_to_boundary_path(down, node_list[1]);
-        node_list[node_list.size()-1]->set_to_boundary_path(up, node_list[node_list.size()-2]);
+        at(node_list[0]).set_to_boundary_path(down, node_list[1]);
+        at(node_list[node_list.size()-1]).set_to_boundary_path(up, node_list[node_list.size()-2]);
         for (size_t i = 1; i < node_list.size()-1; ++i) {
-            node_list[i]->set_to_boundary_path(node_list[i-1], node_list[i+1]);
+            at(node_list[i]).set_to_boundary_path(node_list[i-1], node_list[i+1]);
         }
     }
     //Set the next of up and down.
-    up_next = up->get_next(node_list[node_list.size()-1]);
-    down_next = down->get_next(node_list[0]);
+    up_next = at(up).get_next(node_list[node_list.size()-1]);
+    down_next = at(down).get_next(node_list[0]);
     //Unfold the c-nodes in the node_list.
     for (size_t i = 0; i < node_list.size(); ++i) {
-        if (node_list[i]->type() == C_NODE) c_node_extension(node_list[i]);
+        if (at(node_list[i]).type() == C_NODE) c_node_extension(node_list[i]);
     }
     //Return the new boundary.
-    return pair<pair<node*, node*>, pair<node*, node*> > (pair<node*, node*>(up, up->get_next(up_next)), pair<node*, node*>(down, down->get_next(down_next)));
+    return pair<pair<node_ref, node_ref>, pair<node_ref, node_ref> > (pair<node_ref, node_ref>(up, at(up).get_next(up_next)), pair<node_ref, node_ref>(down, at(down).get_next(down_next)));
 }
 
 //The trim's sub-function.
@@ -836,99 +865,108 @@ maximal_planar_subgraph_finder::trim(node* u) {
 //And then we find that redundent essential node, and remove the nodes that need not remains.
 //Merge the remain part to the higher hierachy.
 void 
-maximal_planar_subgraph_finder::c_node_extension(node* c_node) {
+maximal_planar_subgraph_finder::c_node_extension(node_ref c_node) {
     //size == 2
-    if (c_node->c_node_size() == 2) return;
+    if (at(c_node).c_node_size() == 2) return;
     //size == 3
-    node* sentinel = 0;
-    for (int i = 0; i < c_node->c_node_size(); ++i) {
-        if (!node::is_same(c_node->essential(i), c_node->neighbor(0)) && !node::is_same(c_node->essential(i),  c_node->neighbor(1))) {
-            sentinel = c_node->essential(i);
+    node_ref sentinel = 0;
+    for (int i = 0; i < at(c_node).c_node_size(); ++i) {
+        if (!is_same(essential(c_node, i), at(c_node).neighbor(0)) && !is_same(essential(c_node, i),  at(c_node).neighbor(1))) {
+            sentinel = essential(c_node, i);
             break;
         }
     }
     eliminate(sentinel);
     //The two other essential nodes and their subsequent neighbor.
-    pair<node*, node*> sentinel_0; 
-    pair<node*, node*> sentinel_1;
-    node* n0, * n0_prev = sentinel;
-    node* n1, * n1_prev = sentinel;
-    node* temp = 0;
-    n0 = sentinel->neighbor(0);
-    n1 = sentinel->neighbor(1);
+    pair<node_ref, node_ref> sentinel_0; 
+    pair<node_ref, node_ref> sentinel_1;
+    node_ref n0, n0_prev = sentinel;
+    node_ref n1, n1_prev = sentinel;
+    node_ref temp = 0;
+    n0 = at(sentinel).neighbor(0);
+    n1 = at(sentinel).neighbor(1);
     while (true) {//Toward the direction of n0.
-        if (n0->is_sentinel()) {//If we meet a essential node, stop, don't remove it.
-            sentinel_0 = pair<node*, node*> (n0, n0->get_next(n0_prev));
+        if (at(n0).is_sentinel()) {//If we meet a essential node, stop, don't remove it.
+            sentinel_0 = pair<node_ref, node_ref> (n0, at(n0).get_next(n0_prev));
             break;
         }
         eliminate(n0);
         temp = n0;
-        n0 = n0->get_next(n0_prev);
+        n0 = at(n0).get_next(n0_prev);
         n0_prev = temp;
     }
     while (true) {//Toward the direction of n0.
-        if (n1->is_sentinel()) {//If we meet a essential node, stop, don't remove it.
-            sentinel_1 = pair<node*, node*> (n1, n1->get_next(n1_prev));
+        if (at(n1).is_sentinel()) {//If we meet a essential node, stop, don't remove it.
+            sentinel_1 = pair<node_ref, node_ref> (n1, at(n1).get_next(n1_prev));
             break;
         }
         eliminate(n1);
         temp = n1;
-        n1 = n1->get_next(n1_prev);
+        n1 = at(n1).get_next(n1_prev);
         n1_prev = temp;
     }
 
     //Remember to remove the AE toward two essential nodes that is in the delete region. 
-    eliminate_AE(sentinel_0.first, sentinel_0.first->get_next(sentinel_0.second));
-    eliminate_AE(sentinel_1.first, sentinel_1.first->get_next(sentinel_1.second));
+    eliminate_AE(sentinel_0.first, at(sentinel_0.first).get_next(sentinel_0.second));
+    eliminate_AE(sentinel_1.first, at(sentinel_1.first).get_next(sentinel_1.second));
     //Reset the neighborhood of two essential nodes.
-    sentinel_0.first->set_neighbor(sentinel_1.first, sentinel_0.second);
-    sentinel_1.first->set_neighbor(sentinel_0.first, sentinel_1.second);
+    at(sentinel_0.first).set_neighbor(sentinel_1.first, sentinel_0.second);
+    at(sentinel_1.first).set_neighbor(sentinel_0.first, sentinel_1.second);
     //Merge to upper boundary cycle.
-    merge(pair<pair<node*, node*>, pair<node*, node*> >(sentinel_0, sentinel_1), c_node);
+    merge(pair<pair<node_ref, node_ref>, pair<node_ref, node_ref> >(sentinel_0, sentinel_1), c_node);
 }
 
 //u is a normal p-node.
 //We'll do the work of elimination, and renewing of children-list.
+//The subtree is shaved top-down in pre-order; _shaving_stack holds the nodes still to visit,
+//children pushed in reverse so they are visited in children-list order.
 void 
-maximal_planar_subgraph_finder::recursively_shaving(node* u) { 
-    node* parent_node = 0;
-    node* node_x = 0;
-    pair<node*, node*> new_two_child;
-    vector<node*> new_child_list;
-    //p-node
-    if (u->type() == P_NODE) {
-        for (int i = 0; i < u->child_num(); ++i) recursively_shaving(u->child(i));
-    }
-    //c-node
-    else {
-        //We don't need to shave if u has only one child.
-        if (u->child_num() == 1) {
-            recursively_shaving(u->child(0));
-            return;
+maximal_planar_subgraph_finder::recursively_shaving(node_ref u) { 
+    size_t stack_base = _shaving_stack.size();
+    _shaving_stack.push_back(u);
+    while (_shaving_stack.size() > stack_base) {
+        u = _shaving_stack.back();
+        _shaving_stack.pop_back();
+        node_ref parent_node = 0;
+        node_ref node_x = 0;
+        pair<node_ref, node_ref> new_two_child;
+        vector<node_ref> &new_child_list = _new_child_list;
+        //p-node
+        if (at(u).type() == P_NODE) {
+            for (int i = at(u).child_num() - 1; i >= 0; --i) _shaving_stack.push_back(child(u, i));
         }
-        //More than one child.
-        parent_node = u->parent();
-        //Find node_x, and shave it.
-        for (int i = 0; i < u->c_node_size(); ++i) {
-            if (node::is_same(u->essential(i), parent_node)) {
-                node_x = u->essential(i);
-                new_two_child = shave(node_x);
-                break;
+        //c-node
+        else {
+            //We don't need to shave if u has only one child.
+            if (at(u).child_num() == 1) {
+                _shaving_stack.push_back(child(u, 0));
+                continue;
             }
+            //More than one child.
+            parent_node = at(u).parent();
+            //Find node_x, and shave it.
+            for (int i = 0; i < at(u).c_node_size(); ++i) {
+                if (is_same(essential(u, i), parent_node)) {
+                    node_x = essential(u, i);
+                    new_two_child = shave(node_x);
+                    break;
+                }
+            }
+            //Reset children-list and essential node.
+            new_child_list.clear();
+            for (int i = 0; i < at(u).child_num(); ++i) {
+                if (is_same(child(u, i), new_two_child.first) || is_same(child(u, i), new_two_child.second)) new_child_list.push_back(child(u, i));
+                else eliminate(child(u, i));
+            }
+            at(u).clear_children();
+            at(u).clear_essential();
+            add_essential(u, node_x);
+            add_essential(u, new_two_child.first);
+            add_essential(u, new_two_child.second);
+            add_child(u, new_child_list[0]);
+            add_child(u, new_child_list[1]);
+            for (int i = at(u).child_num() - 1; i >= 0; --i) _shaving_stack.push_back(child(u, i));
         }
-        //Reset children-list and essential node.
-        for (int i = 0; i < u->child_num(); ++i) {
-            if (node::is_same(u->child(i), new_two_child.first) || node::is_same(u->child(i), new_two_child.second)) new_child_list.push_back(u->child(i));
-            else eliminate(u->child(i));
-        }
-        u->clear_children();
-        u->clear_essential();
-        u->add_essential(node_x);
-        u->add_essential(new_two_child.first);
-        u->add_essential(new_two_child.second);
-        u->add_child(new_child_list[0]);
-        u->add_child(new_child_list[1]);
-        for (int i = 0; i < u->child_num(); ++i) recursively_shaving(u->child(i));
     }
 }
 
@@ -938,66 +976,67 @@ maximal_planar_subgraph_finder::recursively_shaving(node* u) {
 //Definition of y_prev, z_prev: ..., y, y_prev, ..., x, ..., z_prev, z, ...
 //Return pair = (y,z). Note: What we return is the replica-node in the inner part of c-node.
 //The work of deleting children will be done by recursively_shaving().
-pair<node*, node*> 
-maximal_planar_subgraph_finder::shave(node* x) {
+pair<node_ref, node_ref> 
+maximal_planar_subgraph_finder::shave(node_ref x) {
     //c-node.
-    node* c_node = x->get_c_node(); 
+    node_ref c_node = at(x).get_c_node(); 
     //No need to shave if child_num == 1.
-    if (c_node->child_num() == 1) return pair<node*, node*>((node*)0, (node*)0); 
+    if (at(c_node).child_num() == 1) return pair<node_ref, node_ref>((node_ref)0, (node_ref)0); 
     //sentinel_1 = (y, y_prev). Note: At this time, c-node must has type equals ARTIFICIAL_EDGE, so no problem here.
-    pair<node*, node*> sentinel_1 = parallel_search_sentinel(x, c_node);
+    pair<node_ref, node_ref> sentinel_1 = parallel_search_sentinel(x, c_node);
     //sentinel_2 = (z, z_prev). Same as above.
-    pair<node*, node*> sentinel_2 = count_sentinel_elimination(sentinel_1, c_node->child_num());
-    return pair<node*, node*>(sentinel_1.first, sentinel_2.first);
+    pair<node_ref, node_ref> sentinel_2 = count_sentinel_elimination(sentinel_1, at(c_node).child_num());
+    return pair<node_ref, node_ref>(sentinel_1.first, sentinel_2.first);
 }
 
 //Use parallel_search to find essential nodes. Return (essential nodes that we find, its prev).
 //x is not in the searching region.
 //If the c-node found is top-tier, then set all the nodes during searching a pointer to c-node, set c to be that c-node, and return pair be all null.
-pair<node*, node*> 
-maximal_planar_subgraph_finder::parallel_search_sentinel(node* x, node* &c) {
-    node* n0, * n0_prev = x;
-    node* n1, * n1_prev = x;
-    n0 = x->neighbor(0);
-    n1 = x->neighbor(1);
+pair<node_ref, node_ref> 
+maximal_planar_subgraph_finder::parallel_search_sentinel(node_ref x, node_ref &c) {
+    node_ref n0, n0_prev = x;
+    node_ref n1, n1_prev = x;
+    n0 = at(x).neighbor(0);
+    n1 = at(x).neighbor(1);
     return parallel_search_sentinel(n0, n0_prev, n1, n1_prev, c);
 }
 
 //Another version of parallel search: n0, n0_prev, ..., n1_prev, n1
 //searching region = (...n0] [n1...). Find the nearest essential node.
 //return (essential nodes that we find, its prev).
-pair<node*, node*> 
-maximal_planar_subgraph_finder::parallel_search_sentinel(node* n0, node* n0_prev, node* n1, node* n1_prev, node* & c) {
-    node* temp = 0;
-    vector<node*> traversed;
+pair<node_ref, node_ref> 
+maximal_planar_subgraph_finder::parallel_search_sentinel(node_ref n0, node_ref n0_prev, node_ref n1, node_ref n1_prev, node_ref & c) {
+    node_ref temp = 0;
+    vector<node_ref> &traversed = _traversed;
+    traversed.clear();
     while (true) {
         //If c-node is top-tier.   
         //note: If c points to a c-node traversed in some previous iteration, then it must not be top-tier, so it'll not pass the if-condition.
-        if (n0->get_c_node() != 0 && n0->get_c_node()->get_2nd_label() == NOT_VISITED) {
-            c = n0->get_c_node();
+        if (at(n0).get_c_node() != 0 && at(at(n0).get_c_node()).get_2nd_label() == NOT_VISITED) {
+            c = at(n0).get_c_node();
             break;
         }
-        if (n1->get_c_node() != 0 && n1->get_c_node()->get_2nd_label() == NOT_VISITED) {
-            c = n1->get_c_node();
+        if (at(n1).get_c_node() != 0 && at(at(n1).get_c_node()).get_2nd_label() == NOT_VISITED) {
+            c = at(n1).get_c_node();
             break;
         }
         //If an essential-node found.
-        if (n0->is_sentinel()) return pair<node*, node*>(n0, n0_prev);
-        if (n1->is_sentinel()) return pair<node*, node*>(n1, n1_prev);
+        if (at(n0).is_sentinel()) return pair<node_ref, node_ref>(n0, n0_prev);
+        if (at(n1).is_sentinel()) return pair<node_ref, node_ref>(n1, n1_prev);
         //Just a normal node..
         traversed.push_back(n0);
         traversed.push_back(n1);
         temp = n0;
-        n0 = n0->get_next(n0_prev);
+        n0 = at(n0).get_next(n0_prev);
         n0_prev = temp;
         temp = n1;
-        n1 = n1->get_next(n1_prev);
+        n1 = at(n1).get_next(n1_prev);
         n1_prev = temp;
     }
 
     //If the c-node found is top-tier, then assign all the traversed node a pointer to c-node.
-    for (size_t i = 0; i < traversed.size(); ++i) traversed[i]->set_c_node(c);
-    return pair<node*, node*>((node*)0, (node*)0);
+    for (size_t i = 0; i < traversed.size(); ++i) at(traversed[i]).set_c_node(c);
+    return pair<node_ref, node_ref>((node_ref)0, (node_ref)0);
 }
 
 // sentinel_1= (y, y_prev)
@@ -1008,31 +1047,31 @@ maximal_planar_subgraph_finder::parallel_search_sentinel(node* n0, node* n0_prev
 // Note: All the node that correspond to the same one as deleted node in higher hierachy will not be affected.
 // The boundary cycle of c-node will be re-connected, AE be properly handled.
 // Do nothing outside the c-node.
-pair<node*, node*> maximal_planar_subgraph_finder::count_sentinel_elimination(pair<node*, node*> sentinel_1, int num_sentinel) {
-    pair<node*, node*> sentinel_2; //(z, z_prev)
+pair<node_ref, node_ref> maximal_planar_subgraph_finder::count_sentinel_elimination(pair<node_ref, node_ref> sentinel_1, int num_sentinel) {
+    pair<node_ref, node_ref> sentinel_2; //(z, z_prev)
     int count = 1;//Count the essential nodes traversed.
-    node* n0 = sentinel_1.first->get_next(sentinel_1.second), * n0_prev = sentinel_1.first;//Going one step further.
-    node* temp = 0;
+    node_ref n0 = at(sentinel_1.first).get_next(sentinel_1.second), n0_prev = sentinel_1.first;//Going one step further.
+    node_ref temp = 0;
     while (true) {
-        if (n0->is_sentinel()) {
+        if (at(n0).is_sentinel()) {
             ++count;//counter
             if (count == num_sentinel) {//We have reached y. Note: We will not eleminate y.
                 sentinel_2.first = n0;
-                sentinel_2.second = n0->get_next(n0_prev);
+                sentinel_2.second = at(n0).get_next(n0_prev);
                 break;
             }
         }
         eliminate(n0);
         temp = n0;
-        n0 = n0->get_next(n0_prev);
+        n0 = at(n0).get_next(n0_prev);
         n0_prev = temp;
     }
     //Remember to eliminate AE toward two essential nodes that is in the deleted region.
-    eliminate_AE(sentinel_2.first, sentinel_2.first->get_next(sentinel_2.second));
-    eliminate_AE(sentinel_1.first, sentinel_1.first->get_next(sentinel_1.second));
+    eliminate_AE(sentinel_2.first, at(sentinel_2.first).get_next(sentinel_2.second));
+    eliminate_AE(sentinel_1.first, at(sentinel_1.first).get_next(sentinel_1.second));
     //Reset neighborhood of two essential nodes.
-    sentinel_2.first->set_neighbor(sentinel_1.first, sentinel_2.second);
-    sentinel_1.first->set_neighbor(sentinel_2.first, sentinel_1.second);
+    at(sentinel_2.first).set_neighbor(sentinel_1.first, sentinel_2.second);
+    at(sentinel_1.first).set_neighbor(sentinel_2.first, sentinel_1.second);
     return sentinel_2;
 }
 
@@ -1041,45 +1080,45 @@ pair<node*, node*> maximal_planar_subgraph_finder::count_sentinel_elimination(pa
 //We'll done the parent-linke of (u -> c-node -> node_i).
 //We don't create child-link here.
 //Default label of newly contructed c-node is (INT_MAX, NOT_VISITED).
-node*
-maximal_planar_subgraph_finder::construct(node* u) {
+node_ref
+maximal_planar_subgraph_finder::construct(node_ref u) {
     //Basic works.
     // int i_label = u->get_1st_label(); // unused
-    node* node_i = _post_order_list[u->get_1st_label()];
+    node_ref node_i = _post_order_list[at(u).get_1st_label()];
     parenting_labeling_shaving(u, node_i);
 
     //Get some new nodes.
-    node* i_sentinel = get_new_node(REPLICA_NODE);
-    node* u_sentinel = get_new_node(REPLICA_NODE);
-    node* new_c_node = get_new_node(C_NODE);
-    node* new_AE_root = get_new_node(AE_VIRTUAL_ROOT);
+    node_ref i_sentinel = get_new_node(REPLICA_NODE);
+    node_ref u_sentinel = get_new_node(REPLICA_NODE);
+    node_ref new_c_node = get_new_node(C_NODE);
+    node_ref new_AE_root = get_new_node(AE_VIRTUAL_ROOT);
 
     //Setting of replica-nodes.
-    i_sentinel->init_replica(node_i, new_c_node);
-    u_sentinel->init_replica(u, new_c_node);
-    for (int i = 0; i < u->child_num(); ++i) {
-        u_sentinel->add_child(u->child(i));
+    init_replica(i_sentinel, node_i, new_c_node);
+    init_replica(u_sentinel, u, new_c_node);
+    for (int i = 0; i < at(u).child_num(); ++i) {
+        add_child(u_sentinel, child(u, i));
     }
-    new_AE_root->init_AE(u_sentinel);
+    init_AE(new_AE_root, u_sentinel);
 
     //Neighborhood setting of replica-nodes in c-node.
-    i_sentinel->set_to_boundary_path(u_sentinel, u_sentinel);
-    u_sentinel->set_to_boundary_path(i_sentinel, i_sentinel);
+    at(i_sentinel).set_to_boundary_path(u_sentinel, u_sentinel);
+    at(u_sentinel).set_to_boundary_path(i_sentinel, i_sentinel);
 
     //Default label of c-node.
-    new_c_node->set_1st_label(INT_MAX);
-    new_c_node->set_2nd_label(NOT_VISITED);
+    at(new_c_node).set_1st_label(INT_MAX);
+    at(new_c_node).set_2nd_label(NOT_VISITED);
 
     //Set essential node of c-node.
-    new_c_node->add_essential(i_sentinel);
-    new_c_node->add_essential(u_sentinel);
+    add_essential(new_c_node, i_sentinel);
+    add_essential(new_c_node, u_sentinel);
 
     //Parenting
-    new_c_node->set_parent(node_i);
-    u->set_parent(new_c_node);
+    at(new_c_node).set_parent(node_i);
+    at(u).set_parent(new_c_node);
 
     //Clear children-list of u_node. (which has benn transfered to AE inside c-node.)
-    u->clear_children();
+    at(u).clear_children();
 
     return new_c_node;
     }
@@ -1089,62 +1128,62 @@ maximal_planar_subgraph_finder::construct(node* u) {
 //But we don't have c->p child-link yet.
 //We are not going to establish that child-link in this function. (Will be done in BET's main loop.)
 //Set c to be DELETED.
-node* 
-maximal_planar_subgraph_finder::construct(node* c, node* p) {
+node_ref 
+maximal_planar_subgraph_finder::construct(node_ref c, node_ref p) {
     //Basic works.
     // int i_label = c->get_1st_label(); // unused var
-    node* node_i = _post_order_list[c->get_1st_label()];
+    node_ref node_i = _post_order_list[at(c).get_1st_label()];
     parenting_labeling_shaving(p, node_i);
     //note: Now, c must have exactly two children left, and c has a parent-link to p, p has achild link to c, too. 
     //Remember to handle them later.
 
     //Get some new nodes.
-    node* i_sentinel = get_new_node(REPLICA_NODE);
-    node* new_c_node = get_new_node(C_NODE);
-    i_sentinel->init_replica(node_i, new_c_node);
+    node_ref i_sentinel = get_new_node(REPLICA_NODE);
+    node_ref new_c_node = get_new_node(C_NODE);
+    init_replica(i_sentinel, node_i, new_c_node);
 
     //Strategy: Build thisboundary cycle first: (i, child(0), c, child(1), i).
     //And then find the two replica-node corresponding to the two children in c, and merge.
-    node* ch0 = c->child(0);
-    node* ch1 = c->child(1);
-    node* AE_root_0 = get_new_node(AE_VIRTUAL_ROOT);
-    node* AE_root_1 = get_new_node(AE_VIRTUAL_ROOT);
-    AE_root_0->init_AE(ch0);
-    AE_root_1->init_AE(ch1);
-    i_sentinel->set_to_boundary_path(ch0, ch1);
-    ch0->set_to_boundary_path(i_sentinel, c);
-    ch1->set_to_boundary_path(i_sentinel, c);
-    c->set_to_boundary_path(ch0, ch1);
+    node_ref ch0 = child(c, 0);
+    node_ref ch1 = child(c, 1);
+    node_ref AE_root_0 = get_new_node(AE_VIRTUAL_ROOT);
+    node_ref AE_root_1 = get_new_node(AE_VIRTUAL_ROOT);
+    init_AE(AE_root_0, ch0);
+    init_AE(AE_root_1, ch1);
+    at(i_sentinel).set_to_boundary_path(ch0, ch1);
+    at(ch0).set_to_boundary_path(i_sentinel, c);
+    at(ch1).set_to_boundary_path(i_sentinel, c);
+    at(c).set_to_boundary_path(ch0, ch1);
         
     //find the boundary in c, merge!
-    node* sent_0;
-    node* sent_1;
-    node* sent_p;
-    for (int i = 0; i < c->c_node_size(); ++i) {
-        if (node::is_same(c->essential(i), ch0)) sent_0 = c->essential(i);
-        else if (node::is_same(c->essential(i), ch1)) sent_1 = c->essential(i);
-        else if (node::is_same(c->essential(i), p)) sent_p = c->essential(i);
+    node_ref sent_0;
+    node_ref sent_1;
+    node_ref sent_p;
+    for (int i = 0; i < at(c).c_node_size(); ++i) {
+        if (is_same(essential(c, i), ch0)) sent_0 = essential(c, i);
+        else if (is_same(essential(c, i), ch1)) sent_1 = essential(c, i);
+        else if (is_same(essential(c, i), p)) sent_p = essential(c, i);
     }
-    merge(pair<pair<node*, node*>, pair<node*, node*> > (pair<node*, node*>(sent_0, sent_0->get_next(sent_1)), pair<node*, node*>(sent_1, sent_1->get_next(sent_0))), c);
+    merge(pair<pair<node_ref, node_ref>, pair<node_ref, node_ref> > (pair<node_ref, node_ref>(sent_0, at(sent_0).get_next(sent_1)), pair<node_ref, node_ref>(sent_1, at(sent_1).get_next(sent_0))), c);
 
     //Set essential-node of c-node.
-    new_c_node->add_essential(i_sentinel);
-    new_c_node->add_essential(sent_p);
+    add_essential(new_c_node, i_sentinel);
+    add_essential(new_c_node, sent_p);
 
     //Default label of c-node.
-    new_c_node->set_1st_label(INT_MAX);
-    new_c_node->set_2nd_label(NOT_VISITED);
+    at(new_c_node).set_1st_label(INT_MAX);
+    at(new_c_node).set_2nd_label(NOT_VISITED);
 
     //Parenting.
-    new_c_node->set_parent(node_i);
+    at(new_c_node).set_parent(node_i);
 
     //p-node, p_sent.
-    sent_p->set_c_node(new_c_node);
-    p->clear_children();
-    p->set_parent(new_c_node);
+    at(sent_p).set_c_node(new_c_node);
+    at(p).clear_children();
+    at(p).set_parent(new_c_node);
 
     //Delete c-node
-    c->set_2nd_label(DELETED);
+    at(c).set_2nd_label(DELETED);
 
     return new_c_node;
 }
@@ -1154,29 +1193,30 @@ maximal_planar_subgraph_finder::construct(node* c, node* p) {
 //In the case of newly constructed c-node itself is c-node, u will be the p-node that trigger the c-node.
 //And in this case, p->c parent-link has been established, but c->p child-link not.
 void 
-maximal_planar_subgraph_finder::parenting_labeling_shaving(node* u, node* node_i) {
+maximal_planar_subgraph_finder::parenting_labeling_shaving(node_ref u, node_ref node_i) {
     //reverse parent-children relation in [u, node_i] as following. 
     //(u-> ... ->y->i) -> (u<- ... <-y , i).
-    vector<node*> u_i_path;
+    vector<node_ref> &u_i_path = _u_i_path;
+    u_i_path.clear();
     u_i_path.push_back(u);
     while (true) {
-        u_i_path.push_back(u_i_path[u_i_path.size()-1]->parent());
+        u_i_path.push_back(at(u_i_path[u_i_path.size()-1]).parent());
         if (u_i_path[u_i_path.size()-1] == node_i) break;
     }
     for (size_t i = 0; i < u_i_path.size()-2; ++i) {
-        u_i_path[i]->add_child(u_i_path[i+1]);
-        u_i_path[i+1]->set_parent(u_i_path[i]);
+        add_child(u_i_path[i], u_i_path[i+1]);
+        at(u_i_path[i+1]).set_parent(u_i_path[i]);
     }
     for (size_t i = 0; i < u_i_path.size()-2; ++i) {
-        for (int j = 0; j < u_i_path[i+1]->child_num(); ++j) {
-            if (u_i_path[i+1]->child(j) == u_i_path[i]) {
-                u_i_path[i+1]->remove_child(j);
+        for (int j = 0; j < at(u_i_path[i+1]).child_num(); ++j) {
+            if (child(u_i_path[i+1], j) == u_i_path[i]) {
+                remove_child(u_i_path[i+1], j);
             }
         }
     }
-    u_i_path[0]->set_parent(0);
+    at(u_i_path[0]).set_parent(0);
 
     //BFS-traversal, all labeled to <i,1>, and then shave the c-node.
-    u->recursively_labeling();
+    recursively_labeling(u);
     recursively_shaving(u);
 }
@@ -0,0 +1,140 @@
+//-----------------------------------------------------------------------------------
+// The finder on ogdf graphs: every entry point converts to an edge_list_graph first.
+// This is the only module that needs OGDF, it is left out of libmps.
+//-----------------------------------------------------------------------------------
+
+#include "mps.h"
+
+#include <ogdf/fileformats/GraphIO.h>
+
+//-----------------------------------------------------------------------------------
+// Finding MPS
+//-----------------------------------------------------------------------------------
+
+// read input file of gml format
+ogdf::Graph read_from_gml(string input_file) {
+    ogdf::Graph G;
+
+    // utilize OGDF readGML
+    if (!ogdf::GraphIO::read(G, input_file, ogdf::GraphIO::readGML)) {
+        std::cerr << "Could not read " << input_file << ".gml" << std::endl;
+    }
+    return G;
+}
+
+int compute_removed_edge_size(const ogdf::Graph &G, vector<int> post_order) {
+    maximal_planar_subgraph_finder m;
+    return m.compute_removed_edge_size(G, post_order);
+}
+
+vector<int> generate_guided_post_order_iterative(const ogdf::Graph &G, const vector<int> &post_order) {
+    maximal_planar_subgraph_finder m;
+    return m.generate_guided_post_order_iterative(G, post_order);
+}
+
+vector<int> generate_mutated_post_order_iterative(const ogdf::Graph &G, const vector<int> &post_order, int mutate_point, mutation_rng &rng) {
+    maximal_planar_subgraph_finder m;
+    return m.generate_mutated_post_order_iterative(G, post_order, mutate_point, rng);
+}
+
+vector<int> generate_post_order_iterative(const ogdf::Graph &G) {
+    maximal_planar_subgraph_finder m;
+    return m.generate_post_order_iterative(G);
+}
+
+void compute_mps(const ogdf::Graph &G, int mutate_point, vector<int> &post_order, int &return_edge_size, mutation_rng &rng) {
+    maximal_planar_subgraph_finder m;
+    m.compute_mps(G, mutate_point, post_order, return_edge_size, rng);
+}
+
+
+//-----------------------------------------------------------------------------------
+// Function implementation for maximal_planar_subgraph_finder object 
+//-----------------------------------------------------------------------------------
+
+vector<int> maximal_planar_subgraph_finder::generate_post_order_iterative(const ogdf::Graph &G) {
+    init_from_graph(G);
+    return generate_post_order_iterative();
+}
+
+vector<int> maximal_planar_subgraph_finder::generate_guided_post_order_iterative(const ogdf::Graph &G, const vector<int> &post_order) {
+    init_from_graph(G);
+    return generate_guided_post_order_iterative(post_order);
+}
+
+vector<int> maximal_planar_subgraph_finder::generate_mutated_post_order_iterative(const ogdf::Graph &G, const vector<int> &post_order, int mutate_point, mutation_rng &rng) {
+    init_from_graph(G);
+    return generate_mutated_post_order_iterative(post_order, mutate_point, rng);
+}
+
+// given a post_order, compute the removed edge size
+int maximal_planar_subgraph_finder::compute_removed_edge_size(const ogdf::Graph &G, vector<int> post_order) {
+    // read_from_gml
+    init_from_graph(G);
+    return compute_removed_edge_size(post_order);
+}
+
+void maximal_planar_subgraph_finder::compute_mps(const ogdf::Graph &G, int mutate_point, vector<int> &post_order, int &return_edge_size, mutation_rng &rng) {
+    init_from_graph(G);
+    compute_mps(mutate_point, post_order, return_edge_size, rng);
+}
+
+// node ids are the ogdf node indices, which are dense for a graph built by reading
+void maximal_planar_subgraph_finder::init_from_graph(const ogdf::Graph &G) {
+    edge_list_graph graph;
+    graph.node_num = G.numberOfNodes();
+    graph.edges.reserve(G.numberOfEdges());
+    for (ogdf::edge e : G.edges) {
+        graph.edges.push_back(make_pair(e->source()->index(), e->target()->index()));
+    }
+    init_from_graph(graph);
+}
+
+// -----
+// Connected components of an ogdf graph
+// -----
+
+void construct_connected_components(ogdf::Graph &G, ogdf::List<ogdf::Graph> &components) {
+    maximal_planar_subgraph_finder m;
+    m.construct_connected_components(G, components);
+}
+
+// the ogdf graphs are built from the views; parallel edges and self-loops are kept
+void 
+maximal_planar_subgraph_finder::construct_connected_components(ogdf::Graph &G, 
+ogdf::List<ogdf::Graph> &components) {
+    edge_list_graph graph;
+    graph.node_num = G.numberOfNodes();
+    graph.edges.reserve(G.numberOfEdges());
+    for (ogdf::edge e : G.edges) {
+        graph.edges.push_back(make_pair(e->source()->index(), e->target()->index()));
+    }
+    vector<unsigned int> offset, target;
+    build_csr(graph, offset, target);
+    csr_graph_view view;
+    view.node_num = graph.node_num;
+    view.offset = offset.data();
+    view.target = target.data();
+    connected_components split;
+    construct_connected_components(view, split);
+
+    vector<ogdf::node> nodes;
+    for (int c = 0; c < split.size(); ++c) {
+        csr_graph_view part = split.component(c);
+        ogdf::Graph &component = *components.emplaceBack();
+        nodes.resize(part.node_num);
+        for (int v = 0; v < part.node_num; ++v) {
+            nodes[v] = component.newNode();
+        }
+        // every edge is listed at both ends, it is added from the smaller one; a self-loop is
+        // listed twice in its row and added every other time
+        for (int v = 0; v < part.node_num; ++v) {
+            bool loop_seen = false;
+            for (unsigned int k = part.offset[v]; k < part.offset[v + 1]; ++k) {
+                int w = part.target[k];
+                if (w == v) loop_seen = !loop_seen;
+                if (w > v || (w == v && loop_seen)) component.newEdge(nodes[v], nodes[w]);
+            }
+        }
+    }
+}
@@ -4,10 +4,6 @@
 
 #include "mps.h"
 #include <cassert>
-#include <unordered_map>
-#include <unordered_set>
-
-#include <ogdf/fileformats/GraphIO.h>
 
 // #define DEBUG
 // #define DEBUG_2
@@ -19,42 +15,10 @@
 
 // programs to call from main:
 
-// read input file of gml format
-ogdf::Graph read_from_gml(string input_file) {
-    ogdf::Graph G;
-
-    // utilize OGDF readGML
-    if (!ogdf::GraphIO::read(G, input_file, ogdf::GraphIO::readGML)) {
-        std::cerr << "Could not read " << input_file << ".gml" << std::endl;
-    }
-    return G;
-}
-
-int compute_removed_edge_size(const ogdf::Graph &G, vector<int> post_order) {
-    maximal_planar_subgraph_finder m;
-    return m.compute_removed_edge_size(G, post_order);
-}
-
-vector<int> generate_guided_post_order_iterative(const ogdf::Graph &G, const vector<int> &post_order) {
-    maximal_planar_subgraph_finder m;
-    return m.generate_guided_post_order_iterative(G, post_order);
-}
-
-vector<int> generate_mutated_post_order_iterative(const ogdf::Graph &G, const vector<int> &post_order, int mutate_point) {
-    maximal_planar_subgraph_finder m;
-    return m.generate_mutated_post_order_iterative(G, post_order, mutate_point);
-}
-
-
-vector<int> generate_post_order_iterative(const ogdf::Graph &G) {
+int compute_removed_edge_size(const edge_list_graph &G, const vector<int> &post_order) {
     maximal_planar_subgraph_finder m;
-    return m.generate_post_order_iterative(G);
-}
-
-
-void compute_mps(const ogdf::Graph &G, int mutate_point, vector<int> &post_order, int &return_edge_size) {
-    maximal_planar_subgraph_finder m;
-    m.compute_mps(G, mutate_point, post_order, return_edge_size);
+    m.init_from_graph(G);
+    return m.compute_removed_edge_size(post_order);
 }
 
 
@@ -63,29 +27,27 @@ void compute_mps(const ogdf::Graph &G, int mutate_point, vector<int> &post_order
 //-----------------------------------------------------------------------------------
 
 
-vector<int> maximal_planar_subgraph_finder::generate_post_order_iterative(const ogdf::Graph &G) {
-    init_from_graph(G);
+vector<int> maximal_planar_subgraph_finder::generate_post_order_iterative() {
+    reset_state();
     post_order_traversal_iterative();
     return return_post_order();
 }
 
-vector<int> maximal_planar_subgraph_finder::generate_guided_post_order_iterative(const ogdf::Graph &G, const vector<int> &post_order) {
-    init_from_graph(G);
+vector<int> maximal_planar_subgraph_finder::generate_guided_post_order_iterative(const vector<int> &post_order) {
+    reset_state();
     guided_post_order_traversal_iterative(post_order);
     return return_post_order();
 }
 
-vector<int> maximal_planar_subgraph_finder::generate_mutated_post_order_iterative(const ogdf::Graph &G, const vector<int> &post_order, int mutate_point) {
-    init_from_graph(G);
-    mutated_post_order_traversal_iterative(post_order, mutate_point);
+vector<int> maximal_planar_subgraph_finder::generate_mutated_post_order_iterative(const vector<int> &post_order, int mutate_point, mutation_rng &rng) {
+    reset_state();
+    mutated_post_order_traversal_iterative(post_order, mutate_point, rng);
     return return_post_order();
 }
 
 
-// given a post_order, compute the removed edge size
-int maximal_planar_subgraph_finder::compute_removed_edge_size(const ogdf::Graph &G, vector<int> post_order) {
-    // read_from_gml
-    init_from_graph(G);
+int maximal_planar_subgraph_finder::compute_removed_edge_size(const vector<int> &post_order) {
+    reset_state();
     guided_post_order_traversal_iterative(post_order);
     // std::cout << "-----" << std::endl;
     // std::cout << "compute removedd edged size" << std::endl;
@@ -99,35 +61,47 @@ int maximal_planar_subgraph_finder::compute_removed_edge_size(const ogdf::Graph
     return output_removed_edge_size();
 }
 
-// clear the internal _post_order_list
+// reset everything that a traversal or a back-edge-traversal writes, in O(n+m)
+// the graph-derived state (nodes, input adjacency) built by init_from_graph is kept
 void maximal_planar_subgraph_finder::reset_state() {
     _post_order_list.clear();
+    _open_order.clear();
     _edge_list.clear();
     _back_edge_list.clear();
     _is_back_edge_eliminate.clear();
-    // we also need to reset the mark of every node
-    for (auto node:_node_list) {
-        node->un_mark();
+    _back_edge_weight.clear();
+    _eliminated_num = 0;
+    // marks, labels, parents and children of every input node
+    // the unmarked counts are only set up when a mutated traversal needs them
+    for (int i = 0; i < _node_num; ++i) {
+        at(input_node(i)).reset();
     }
+    _mark.assign(_node_num, UNMARKED);
+    _unmarked_counts_valid = false;
+    // replica-nodes, c-nodes and AE-roots of the previous evaluation are released,
+    // together with all lists
+    _node_pool.reset(_node_num);
 }
 
-void maximal_planar_subgraph_finder::compute_mps(const ogdf::Graph &G, int mutate_point, vector<int> &post_order, int &return_edge_size) {
+
+// with a cutoff, a candidate that removes at least cutoff edges is abandoned part way:
+// return_edge_size is then only known to be >= cutoff and post_order is left unchanged
+// post_order is only written for a candidate below the cutoff, the one a caller keeps
+void maximal_planar_subgraph_finder::compute_mps(int mutate_point, vector<int> &post_order, int &return_edge_size, mutation_rng &rng, int cutoff) {
     // part 1:
     // we first generate a new mutated order, and then compute the removed edge size for that
-    init_from_graph(G);
-    mutated_post_order_traversal_iterative(post_order, mutate_point);
+    reset_state();
+    mutated_post_order_traversal_iterative(post_order, mutate_point, rng);
     // compute MPS on the immediate tree produced by mutated traversal
     sort_adj_list();
     determine_edges();
-    back_edge_traversal();
+    back_edge_traversal(cutoff);
     return_edge_size = output_removed_edge_size();
+    if (return_edge_size >= cutoff) return;
 
-
-    vector<int> temp_order = return_post_order();
-    reset_state();
-    // part 2: compute mps with correct orientation tree
-    guided_post_order_traversal_iterative(temp_order);
-    post_order = return_post_order();
+    // part 2: the post_order of the tree with correct orientation
+    // it is read off the first traversal, see return_oriented_post_order()
+    post_order = return_oriented_post_order();
 }
 
 // previous implementation did not rotate result
@@ -148,77 +122,487 @@ void maximal_planar_subgraph_finder::compute_mps(const ogdf::Graph &G, int mutat
 // Input, output
 //-----------------------------------------------------------------------------------
 
-void maximal_planar_subgraph_finder::init_from_graph(const ogdf::Graph &G) {
-    // create nodes
-    _node_list.reserve(G.numberOfNodes());
-    for (int i = 0; i < G.numberOfNodes(); ++i) {
-        _node_list.push_back(new node(P_NODE));
-        _node_list[i]->set_id(i);
+
+void maximal_planar_subgraph_finder::init_from_graph(const edge_list_graph &G) {
+    // the finder may be reused, so release everything from the previous graph first
+    _node_pool.reset();
+
+    // create nodes, node id i gets handle input_node(i)
+    for (int i = 0; i < G.node_num; ++i) {
+        _node_pool.get_new_node(P_NODE);
     }
+    _node_num = G.node_num;
+    reset_state();
 
-    // create edges
-    for (ogdf::edge e : G.edges) {
-        ogdf::node source = e->source();
-        ogdf::node target = e->target();
-        _node_list[source->index()]->add_adj(_node_list[target->index()]);
-        _node_list[source->index()]->add_unmarked();
-        _node_list[target->index()]->add_adj(_node_list[source->index()]);
-        _node_list[target->index()]->add_unmarked();
+    // create edges as CSR: count degrees, prefix-sum them into offsets, then fill
+    // each row in edge order so the neighbor order is the order of G.edges
+    // self-loops never affect planarity, so they are left out
+    _adj_offset.assign(G.node_num + 1, 0);
+    for (const pair<int, int> &e : G.edges) {
+        if (e.first == e.second) continue;
+        _adj_offset[e.first + 1]++;
+        _adj_offset[e.second + 1]++;
+    }
+    for (int i = 0; i < G.node_num; ++i) {
+        _adj_offset[i + 1] += _adj_offset[i];
+    }
+    _adj_target.resize(_adj_offset[G.node_num]);
+    vector<int> fill(_adj_offset.begin(), _adj_offset.end() - 1);
+    for (const pair<int, int> &e : G.edges) {
+        if (e.first == e.second) continue;
+        _adj_target[fill[e.first]++] = e.second;
+        _adj_target[fill[e.second]++] = e.first;
+    }
+
+    // parallel edges are merged into their first copy, which is weighted by the number of copies
+    // a multigraph is planar iff its simple graph is, so an edge is kept or removed with all of
+    // its copies, and a removed edge counts with its weight
+    // rows are compacted in place, an entry never moves behind its old position
+    vector<int> weight(_adj_target.size());
+    vector<int> position(G.node_num, -1); // where a neighbor sits in the current row
+    bool has_parallel = false;
+    int write = 0;
+    for (int i = 0; i < G.node_num; ++i) {
+        int row_begin = write;
+        int read_end = _adj_offset[i + 1];
+        for (int k = _adj_offset[i]; k < read_end; ++k) {
+            int target = _adj_target[k];
+            if (position[target] >= row_begin) {
+                ++weight[position[target]];
+                has_parallel = true;
+                continue;
+            }
+            position[target] = write;
+            weight[write] = 1;
+            _adj_target[write++] = target;
+        }
+        _adj_offset[i] = row_begin;
+    }
+    _adj_offset[G.node_num] = write;
+    _adj_target.resize(write);
+    if (has_parallel) {
+        weight.resize(write);
+        _adj_weight.swap(weight);
+    } else {
+        _adj_weight.clear();
     }
 }
 
-// count the number of removed edges
+// count the number of removed edges, parallel input edges included
+// kept as a running count by the back-edge-traversal
 int maximal_planar_subgraph_finder::output_removed_edge_size() {
-    int sum = 0;
+    return _eliminated_num;
+}
+
+// the removed edges as pairs of node ids, a pair of parallel input edges only once
+vector<pair<int, int> > maximal_planar_subgraph_finder::output_removed_edges() {
+    vector<pair<int, int> > removed_edges;
     for (size_t i = 0; i < _back_edge_list.size(); ++i) {
-        if (_is_back_edge_eliminate[i]) ++sum; 
+        if (!_is_back_edge_eliminate[i]) continue;
+        removed_edges.push_back(make_pair(node_id(_back_edge_list[i].first), node_id(_back_edge_list[i].second)));
     }
-    return sum;
+    return removed_edges;
 }
 
 // -----
-// DFS for main to separate disconnected graph into separate components
+// Connected components for mps_solve: the blocks are searched for one component at a time
 // -----
 
-void construct_connected_components(ogdf::Graph &G, ogdf::List<ogdf::Graph> &components) {
+
+void construct_connected_components(const csr_graph_view &G, connected_components &components) {
     maximal_planar_subgraph_finder m;
     m.construct_connected_components(G, components);
 }
 
-void 
-maximal_planar_subgraph_finder::construct_connected_components(ogdf::Graph &G, 
-ogdf::List<ogdf::Graph> &components) {
-    init_from_graph(G);
-    for (size_t i = 0; i < _node_list.size(); ++i) {
-        if (!_node_list[i]->is_marked()) {
-            ogdf::Graph component;
-            // this is a vector of nodes in a connected component
-            vector<node*> return_node_list;
-            dfs_cc(_node_list[i], return_node_list);
-            // now we construct a Graph using the return_node_list
-            unordered_map<int, ogdf::node> index_to_node;
-            for (auto current_node : return_node_list) {
-                ogdf::node v = component.newNode(current_node->node_id());
-                index_to_node[current_node->node_id()] = v;
+// lay the edges out as rows, in the order of the edge list, every edge at both end points
+void build_csr(const edge_list_graph &G, vector<unsigned int> &offset, vector<unsigned int> &target) {
+    int n = G.node_num;
+    offset.assign(n + 1, 0);
+    for (const pair<int, int> &e : G.edges) {
+        offset[e.first + 1]++;
+        offset[e.second + 1]++;
+    }
+    for (int i = 0; i < n; ++i) {
+        offset[i + 1] += offset[i];
+    }
+    target.resize(offset[n]);
+    vector<unsigned int> fill(offset.begin(), offset.end() - 1);
+    for (const pair<int, int> &e : G.edges) {
+        target[fill[e.first]++] = e.second;
+        target[fill[e.second]++] = e.first;
+    }
+}
+
+csr_graph_view connected_components::component(int i) const {
+    csr_graph_view view;
+    view.node_num = node_begin[i + 1] - node_begin[i];
+    view.offset = offset.data() + node_begin[i];
+    view.target = target.data();
+    return view;
+}
+
+
+// one pass over the graph, O(n+m): a breadth-first search from every node not yet reached
+// numbers the nodes component by component, then the rows are copied over in the new order
+// original_id is filled in search order, so it doubles as the queue of the search
+void
+maximal_planar_subgraph_finder::construct_connected_components(const csr_graph_view &G,
+connected_components &components) {
+    int n = G.node_num;
+    vector<int> new_id(n, -1);
+    components.original_id.clear();
+    components.original_id.reserve(n);
+    components.node_begin.assign(1, 0);
+    vector<int> &queue = components.original_id;
+    for (int root = 0; root < n; ++root) {
+        if (new_id[root] != -1) continue;
+        new_id[root] = queue.size();
+        queue.push_back(root);
+        for (size_t head = components.node_begin.back(); head < queue.size(); ++head) {
+            int v = queue[head];
+            for (unsigned int k = G.offset[v]; k < G.offset[v + 1]; ++k) {
+                int w = G.target[k];
+                if (new_id[w] == -1) {
+                    new_id[w] = queue.size();
+                    queue.push_back(w);
+                }
             }
-            // we keep an unordered set of edges to only add edges if its never been added
-            unordered_set<pair<int,int>, PairHash> added_edges;
-            for (auto current_node : return_node_list) {
-                vector<node*> neighbor_list = current_node->_adj_list;
-                for (auto it = neighbor_list.begin(); it != neighbor_list.end(); ++it) {
-                    node* neighbor_node = (*it);
-                    int first_node = current_node->node_id();
-                    int second_node = neighbor_node->node_id();
-                    // only add edge if never seen before
-                    if (added_edges.find(make_pair(first_node, second_node)) == added_edges.end()) {
-                        component.newEdge(index_to_node[first_node], 
-                                        index_to_node[second_node]);
-                        added_edges.insert(make_pair(first_node, second_node));
-                        added_edges.insert(make_pair(second_node, first_node));
+        }
+        components.node_begin.push_back(queue.size());
+    }
+
+    // the targets are stored with the ids local to their component, so that a view of the
+    // component only has to shift the offsets
+    components.offset.resize(n + 1);
+    components.target.resize(G.offset[n] - G.offset[0]);
+    unsigned int position = 0;
+    for (int c = 0; c + 1 < static_cast<int>(components.node_begin.size()); ++c) {
+        int begin = components.node_begin[c];
+        for (int x = begin; x < components.node_begin[c + 1]; ++x) {
+            int v = components.original_id[x];
+            components.offset[x] = position;
+            for (unsigned int k = G.offset[v]; k < G.offset[v + 1]; ++k) {
+                components.target[position++] = new_id[G.target[k]] - begin;
+            }
+        }
+    }
+    components.offset[n] = position;
+}
+
+// -----
+// Block decomposition for main: a graph is planar iff each of its biconnected blocks is,
+// so a maximal planar subgraph is found block by block
+// -----
+
+void construct_biconnected_blocks(const csr_graph_view &G, vector<edge_list_graph> &blocks,
+                                  vector<vector<int> > *block_nodes) {
+    maximal_planar_subgraph_finder m;
+    m.construct_biconnected_blocks(G, blocks, block_nodes);
+}
+
+// Hopcroft-Tarjan on an explicit stack, O(n+m)
+// edges are pushed on an edge stack as (lower end, upper end) as they are traversed, and a block
+// is popped off it when a child v of u finishes with low[v] >= disc[u]
+// rows carry no edge ids, so the tree edge to the parent is skipped once and any parallel copy
+// of it is taken as a back edge
+// only blocks that may be non-planar are returned: a non-planar graph contains a subdivision
+// of K5 or K3,3 and so has m - n + 1 >= 4, which rules out bridges, cycles and any block with
+// at most two more edges than nodes; self-loops never matter for planarity and are dropped
+// with block_nodes, the ids in G of the nodes of every returned block are added to it
+void
+maximal_planar_subgraph_finder::construct_biconnected_blocks(const csr_graph_view &G,
+vector<edge_list_graph> &blocks, vector<vector<int> > *block_nodes) {
+    int n = G.node_num;
+    const unsigned int *offset = G.offset;
+    const unsigned int *target = G.target;
+
+    struct block_frame {
+        int node;
+        int parent;
+        unsigned int next;
+    };
+    vector<int> disc(n, -1);
+    vector<int> low(n, 0);
+    vector<block_frame> stack;
+    vector<pair<int, int> > edge_stack;
+    vector<pair<int, int> > block_edges;
+    // block-local node ids, valid while block_stamp matches
+    vector<int> local_id(n, -1);
+    vector<int> block_stamp(n, -1);
+    int time = 0;
+    int block_num = 0;
+
+    for (int root = 0; root < n; ++root) {
+        if (disc[root] != -1) continue;
+        disc[root] = low[root] = time++;
+        stack.push_back(block_frame{root, -1, offset[root]});
+        while (!stack.empty()) {
+            block_frame &frame = stack.back();
+            int v = frame.node;
+            if (frame.next < offset[v + 1]) {
+                int w = target[frame.next++];
+                if (w == frame.parent) {
+                    frame.parent = -1;
+                    continue;
+                }
+                if (disc[w] == -1) {
+                    // tree edge
+                    edge_stack.push_back(make_pair(v, w));
+                    disc[w] = low[w] = time++;
+                    stack.push_back(block_frame{w, v, offset[w]});
+                } else if (disc[w] < disc[v]) {
+                    // back edge, seen from its lower end
+                    edge_stack.push_back(make_pair(v, w));
+                    low[v] = std::min(low[v], disc[w]);
+                }
+                continue;
+            }
+            stack.pop_back();
+            if (stack.empty()) break;
+            int u = stack.back().node;
+            low[u] = std::min(low[u], low[v]);
+            if (low[v] < disc[u]) continue;
+
+            // u separates the subtree of v, the edges above the tree edge (u, v) form a block
+            // a back edge is never stored as (u, v), since v is below u
+            block_edges.clear();
+            pair<int, int> e;
+            do {
+                e = edge_stack.back();
+                edge_stack.pop_back();
+                block_edges.push_back(e);
+            } while (e.first != u || e.second != v);
+            int block_node_num = 0;
+            for (const pair<int, int> &b : block_edges) {
+                for (int x : {b.first, b.second}) {
+                    if (block_stamp[x] != block_num) {
+                        block_stamp[x] = block_num;
+                        local_id[x] = block_node_num++;
                     }
                 }
             }
-            components.pushBack(component);
+            ++block_num;
+            if (static_cast<int>(block_edges.size()) - block_node_num + 1 < 4) continue;
+
+            blocks.emplace_back();
+            edge_list_graph &block = blocks.back();
+            block.node_num = block_node_num;
+            block.edges.reserve(block_edges.size());
+            for (const pair<int, int> &b : block_edges) {
+                block.edges.push_back(make_pair(local_id[b.first], local_id[b.second]));
+            }
+            if (block_nodes != nullptr) {
+                block_nodes->emplace_back(block_node_num);
+                for (const pair<int, int> &b : block_edges) {
+                    block_nodes->back()[local_id[b.first]] = b.first;
+                    block_nodes->back()[local_id[b.second]] = b.second;
+                }
+            }
         }
     }
-}
\ No newline at end of file
+}
+
+// -----
+// Reduction for main: the search only needs the part of a graph where planarity is decided
+// -----
+
+// kernel gets a graph with the same number of removed edges as G, where every node has at least
+// three distinct neighbors
+// - a node with at most one distinct neighbor is peeled, its edges can always be kept
+// - a node x with exactly two, u and v, is contracted into an edge (u, v): keeping the path keeps
+//   everything, cutting it costs the cheaper of the bundles (x, u) and (x, v); the contracted edge
+//   joins a parallel (u, v), which is planar iff the simple graph is
+// - self-loops are dropped, they never affect planarity
+// weights are written to kernel as parallel edges, which the finder merges back into weights
+// removals can create new nodes with two neighbors or less, so nodes are queued until none is left
+// with edge_sets, the edges of G that cutting a kernel bundle removes are returned, as indices in
+// G.edges, one set per bundle in the order the bundles appear in kernel.edges
+// everything lives in flat arrays: the parallel edges of G are found by sorting rows, every node
+// keeps a row of its bundles, and an open-addressing table of bundle ids answers whether u and v
+// are already joined when a node between them is contracted
+void reduce_graph(const edge_list_graph &G, edge_list_graph &kernel, vector<vector<int> > *edge_sets) {
+    int n = G.node_num;
+
+    // the edges by lower end, sorted by upper end and then by index, so that copies are adjacent
+    vector<unsigned int> lower_offset(n + 1, 0);
+    for (const pair<int, int> &e : G.edges) {
+        if (e.first != e.second) lower_offset[std::min(e.first, e.second) + 1]++;
+    }
+    for (int i = 0; i < n; ++i) {
+        lower_offset[i + 1] += lower_offset[i];
+    }
+    vector<uint64_t> upper(lower_offset[n]);
+    vector<unsigned int> fill(lower_offset.begin(), lower_offset.end() - 1);
+    for (size_t e = 0; e < G.edges.size(); ++e) {
+        int u = G.edges[e].first;
+        int v = G.edges[e].second;
+        if (u == v) continue;
+        upper[fill[std::min(u, v)]++] = static_cast<uint64_t>(std::max(u, v)) << 32 | e;
+    }
+    vector<unsigned int>().swap(fill);
+
+    // bundle b joins bundle_end[2b] and bundle_end[2b+1] with weight[b] edges, 0 once it is gone
+    // with edge_sets, its edges are a list from member_head[b] through member_next
+    vector<int> bundle_end;
+    vector<int> weight;
+    vector<int> member_head, member_tail, member_next;
+    if (edge_sets != nullptr) member_next.assign(G.edges.size(), -1);
+    vector<int> degree(n, 0); //Number of distinct neighbors.
+    for (int u = 0; u < n; ++u) {
+        std::sort(upper.begin() + lower_offset[u], upper.begin() + lower_offset[u + 1]);
+        for (unsigned int k = lower_offset[u]; k < lower_offset[u + 1]; ++k) {
+            int v = upper[k] >> 32;
+            int e = upper[k] & 0xFFFFFFFFu;
+            if (k == lower_offset[u] || v != static_cast<int>(upper[k - 1] >> 32)) {
+                bundle_end.push_back(u);
+                bundle_end.push_back(v);
+                weight.push_back(0);
+                ++degree[u];
+                ++degree[v];
+                if (edge_sets != nullptr) {
+                    member_head.push_back(e);
+                    member_tail.push_back(e);
+                }
+            } else if (edge_sets != nullptr) {
+                member_next[member_tail.back()] = e;
+                member_tail.back() = e;
+            }
+            ++weight.back();
+        }
+    }
+    vector<uint64_t>().swap(upper);
+    vector<unsigned int>().swap(lower_offset);
+    int bundle_num = weight.size();
+
+    // row_bundle[row_offset[x] ...] are the bundles at x; slot[2b+s] is where bundle b sits in the
+    // row of bundle_end[2b+s], so that a bundle can take over the slot of another one
+    vector<unsigned int> row_offset(n + 1, 0);
+    for (int i = 0; i < n; ++i) {
+        row_offset[i + 1] = row_offset[i] + degree[i];
+    }
+    vector<int> row_bundle(row_offset[n]);
+    vector<unsigned int> slot(2 * bundle_num);
+    fill.assign(row_offset.begin(), row_offset.end() - 1);
+    for (int b = 0; b < bundle_num; ++b) {
+        for (int s = 0; s < 2; ++s) {
+            slot[2 * b + s] = fill[bundle_end[2 * b + s]]++;
+            row_bundle[slot[2 * b + s]] = b;
+        }
+    }
+    vector<unsigned int>().swap(fill);
+
+    // the table holds bundle ids by their end points; an entry whose bundle is gone or has been
+    // moved to other end points is skipped, and the table is rebuilt once half of it is used
+    vector<int> table;
+    size_t table_used = 0;
+    auto position = [&table](int u, int v) {
+        uint64_t key = static_cast<uint64_t>(std::min(u, v)) << 32 | std::max(u, v);
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (table.size() - 1);
+    };
+    auto insert = [&](int b) {
+        size_t p = position(bundle_end[2 * b], bundle_end[2 * b + 1]);
+        while (table[p] != -1) p = (p + 1) & (table.size() - 1);
+        table[p] = b;
+        ++table_used;
+    };
+    auto rebuild = [&]() {
+        size_t live = 0;
+        for (int b = 0; b < bundle_num; ++b) {
+            if (weight[b] > 0) ++live;
+        }
+        size_t capacity = 16;
+        while (capacity < 4 * live) capacity *= 2;
+        table.assign(capacity, -1);
+        table_used = 0;
+        for (int b = 0; b < bundle_num; ++b) {
+            if (weight[b] > 0) insert(b);
+        }
+    };
+    auto find_bundle = [&](int u, int v) {
+        for (size_t p = position(u, v); table[p] != -1; p = (p + 1) & (table.size() - 1)) {
+            int b = table[p];
+            if (weight[b] > 0 && ((bundle_end[2 * b] == u && bundle_end[2 * b + 1] == v) || (bundle_end[2 * b] == v && bundle_end[2 * b + 1] == u))) return b;
+        }
+        return -1;
+    };
+    rebuild();
+
+    vector<bool> removed(n, false);
+    vector<int> queue;
+    for (int i = 0; i < n; ++i) {
+        if (degree[i] <= 2) queue.push_back(i);
+    }
+    int at_x[2]; //The bundles left at x.
+    while (!queue.empty()) {
+        int x = queue.back();
+        queue.pop_back();
+        if (removed[x] || degree[x] > 2) continue;
+        removed[x] = true;
+        int found = 0;
+        for (unsigned int k = row_offset[x]; k < row_offset[x + 1] && found < degree[x]; ++k) {
+            int b = row_bundle[k];
+            if (weight[b] > 0 && (bundle_end[2 * b] == x || bundle_end[2 * b + 1] == x)) at_x[found++] = b;
+        }
+        if (degree[x] <= 1) {
+            if (degree[x] == 1) {
+                int b = at_x[0];
+                int u = bundle_end[2 * b] == x ? bundle_end[2 * b + 1] : bundle_end[2 * b];
+                weight[b] = 0;
+                if (--degree[u] <= 2) queue.push_back(u);
+            }
+            continue;
+        }
+        int a = at_x[0];
+        int b = at_x[1];
+        int cut = (weight[a] <= weight[b]) ? a : b;
+        int other = (cut == a) ? b : a;
+        int cut_x = bundle_end[2 * cut] == x ? 0 : 1; //The side of cut at x.
+        int u = bundle_end[2 * cut + 1 - cut_x];
+        int other_v = bundle_end[2 * other] == x ? 1 : 0; //The side of other away from x.
+        int v = bundle_end[2 * other + other_v];
+        int uv = find_bundle(u, v);
+        weight[other] = 0;
+        if (uv == -1) {
+            // cut now joins u and v, in the slot other had in the row of v
+            bundle_end[2 * cut + cut_x] = v;
+            slot[2 * cut + cut_x] = slot[2 * other + other_v];
+            row_bundle[slot[2 * cut + cut_x]] = cut;
+            if (2 * (table_used + 1) > table.size()) rebuild();
+            else insert(cut);
+        } else {
+            weight[uv] += weight[cut];
+            weight[cut] = 0;
+            if (edge_sets != nullptr) {
+                member_next[member_tail[uv]] = member_head[cut];
+                member_tail[uv] = member_tail[cut];
+            }
+            if (--degree[u] <= 2) queue.push_back(u);
+            if (--degree[v] <= 2) queue.push_back(v);
+        }
+    }
+
+    vector<int> kernel_id(n, -1);
+    kernel.node_num = 0;
+    kernel.edges.clear();
+    if (edge_sets != nullptr) edge_sets->clear();
+    for (int i = 0; i < n; ++i) {
+        if (!removed[i]) kernel_id[i] = kernel.node_num++;
+    }
+    for (int i = 0; i < n; ++i) {
+        if (removed[i]) continue;
+        for (unsigned int k = row_offset[i]; k < row_offset[i + 1]; ++k) {
+            int b = row_bundle[k];
+            if (weight[b] == 0) continue;
+            int j = bundle_end[2 * b] == i ? bundle_end[2 * b + 1] : bundle_end[2 * b];
+            if (j < i) continue;
+            for (int c = 0; c < weight[b]; ++c) {
+                kernel.edges.push_back(make_pair(kernel_id[i], kernel_id[j]));
+            }
+            if (edge_sets != nullptr) {
+                edge_sets->emplace_back();
+                for (int e = member_head[b]; e != -1; e = member_next[e]) edge_sets->back().push_back(e);
+            }
+        }
+    }
+}
+
@@ -11,116 +11,120 @@
 // CONSTRUCTOR
 //-----------------------------------------------------------------------------------
 node::node(node_type t) {
+	reinit(t);
+}
+
+//Bring the node back to its freshly constructed state.
+//The lists are emptied; their blocks are released together by node_pool::reset().
+void node::reinit(node_type t) {
 	_type = t;
-	_label = pair<int, label>(INT_MAX, NOT_VISITED);
+	reset();
+}
+
+//Clear everything written by a traversal or by the back-edge-traversal.
+//The type is kept, so the node is ready for the next DFS-tree.
+void node::reset() {
+	_1st_label = INT_MAX;
+	_2nd_label = NOT_VISITED;
 	_neighbor[0] = _neighbor[1] = 0;
 	_AE_root[0] = _AE_root[1]  = 0;
-	_original_node = 0; 
+	_original_node = 0;
     _c_node = 0;
 	_parent = 0;
 	_post_order_index = INT_MAX;
-	_node_id = INT_MAX;
-	_mark = UNMARKED;
-    _unmarked_neighbors_count = 0;
+	_children.begin = _children.size = 0;
+	_essential_list.begin = _essential_list.size = 0;
 }
 
 //-----------------------------------------------------------------------------------
-// TYPE, ID, INDEX
+// TYPE, INDEX
 //-----------------------------------------------------------------------------------
 node_type node::type() {return _type;}
 
 int node::post_order_index() {return _post_order_index;}
 
-void node::set_id(int i) {_node_id = i;}
-
 void node::set_post_order_index(int i) {_post_order_index = i;}
 
 //Only used when consturcting c-node
 //The first node calling this function would not be labeled.
-void node::recursively_labeling() {		
-	for (size_t i = 0; i < _children.size(); ++i) {
-		_children[i]->_label.second = ARTIFICIAL_EDGE;
-		_children[i]->recursively_labeling();
-	} 
+//The subtree is walked with _labeling_stack.
+void maximal_planar_subgraph_finder::recursively_labeling(node_ref u) {
+	_labeling_stack.push_back(u);
+	while (!_labeling_stack.empty()) {
+		u = _labeling_stack.back();
+		_labeling_stack.pop_back();
+		for (int i = 0; i < at(u).child_num(); ++i) {
+			at(child(u, i)).set_2nd_label(ARTIFICIAL_EDGE);
+			_labeling_stack.push_back(child(u, i));
+		}
+	}
 }
 
-int node::node_id() {return _node_id;}
-
 //-----------------------------------------------------------------------------------
 // DFS-TREE
 //-----------------------------------------------------------------------------------
-void node::add_adj(node* n) {_adj_list.push_back(n);}
-
-int node::degree() {return _adj_list.size();}
-
-node* node::adj(int i) {return _adj_list[i];}
-
-void node::set_adj_list(vector<node*> vec) {_adj_list = vec;}
-
+// adjacency is stored by the finder, see maximal_planar_subgraph_finder::degree()
 // recursive implementation is removed
 // iteratie implementation is found in mps.cpp
 
 //-----------------------------------------------------------------------------------
 // PARENT-CHILDREN
 //-----------------------------------------------------------------------------------
-int node::child_num() {return _children.size();}
-
-node* node::child(int i) {return _children[i];}
+int node::child_num() {return _children.size;}
 
-node* node::parent() {return _parent;}
+node_ref node::parent() {return _parent;}
 
 void node::clear_children() {
-	_children.clear();
+	_children.size = 0;
 }
 
-void node::remove_child(int i) {
-	_children[i] = _children[_children.size()-1];
-	_children.resize(_children.size()-1);
+ref_list &node::children() {return _children;}
+
+void node::set_parent(node_ref n) {
+	_parent= n;
 }
 
-void node::remove_child(node* n) {
-	for (size_t i = 0; i < _children.size(); ++i) {
-	    if (_children[i] == n) {
-			_children[i] = _children[_children.size()-1];
-	        _children.resize(_children.size()-1);
-		}
-	}
+node_ref maximal_planar_subgraph_finder::child(node_ref u, int i) {
+	return _node_pool.list_at(at(u).children(), i);
 }
 
-void node::add_child(node* n) {
-	_children.push_back(n);
+void maximal_planar_subgraph_finder::remove_child(node_ref u, int i) {
+	_node_pool.list_remove(at(u).children(), i);
 }
 
-vector<node*>* node::get_children_list() {
-	vector<node*>* ptr = new vector<node*>(_children);
-	return ptr;
+void maximal_planar_subgraph_finder::remove_child(node_ref u, node_ref n) {
+	for (int i = 0; i < at(u).child_num(); ++i) {
+	    if (child(u, i) == n) {
+			_node_pool.list_remove(at(u).children(), i);
+		}
+	}
 }
 
-void node::set_parent(node* n) {
-	_parent= n;
+void maximal_planar_subgraph_finder::add_child(node_ref u, node_ref n) {
+	_node_pool.list_push_back(at(u).children(), n);
 }
 
 //-----------------------------------------------------------------------------------
 // BOUNDARY_PATH
 //-----------------------------------------------------------------------------------
-void node::set_to_boundary_path(node* n0, node* n1) {
+void node::set_to_boundary_path(node_ref n0, node_ref n1) {
 	_parent = 0;
-	_children.clear();
+	_children.size = 0;
 	_neighbor[0] = n0;
 	_neighbor[1] = n1;
 	set_2nd_label(BOUNDARY_PATH);
 }
 
-node* node::get_next(node* prev) {
+node_ref node::get_next(node_ref prev) {
 	if (_neighbor[0] != prev) return _neighbor[0];
 	else return _neighbor[1];
 }
 
-node* node::neighbor(int i) {return _neighbor[i];}
+node_ref node::neighbor(int i) {return _neighbor[i];}
 
-void node::set_neighbor(int i, node* n) {_neighbor[i] = n;}
+void node::set_neighbor(int i, node_ref n) {_neighbor[i] = n;}
 
-void node::set_neighbor(node* u, node* v) {
+void node::set_neighbor(node_ref u, node_ref v) {
 	_neighbor[0] = u;
 	_neighbor[1] = v;
 }
@@ -128,121 +132,170 @@ void node::set_neighbor(node* u, node* v) {
 //-----------------------------------------------------------------------------------
 // ARTIFICIAL EDGE
 //-----------------------------------------------------------------------------------
-node* node::AE(int i) {return _AE_root[i];}
+node_ref node::AE(int i) {return _AE_root[i];}
 
-void node::set_AE(int i, node* j) {
-	_AE_root[i] = j;
-	if (j != 0) j->set_parent(this);
-} 
+void node::set_AE(int i, node_ref j) {_AE_root[i] = j;}
 
-void node::add_AE(node* j) {
+void maximal_planar_subgraph_finder::set_AE(node_ref u, int i, node_ref j) {
+	at(u).set_AE(i, j);
+	if (j != 0) at(j).set_parent(u);
+}
+
+void maximal_planar_subgraph_finder::add_AE(node_ref u, node_ref j) {
 	if (j == 0) return;
-	if (_AE_root[0] == 0) set_AE(0, j);
-	else if (_AE_root[1] == 0) set_AE(1, j);
-}
-
-//Inherit u's artificial edge.
-void node::inherit_AE(node* u) {
-	if (u->_AE_root[0] != 0) add_AE(u->_AE_root[0]);
-	if (u->_AE_root[1] != 0) add_AE(u->_AE_root[1]);
-	u->_AE_root[0] = u->_AE_root[1] = 0;
-}
-
-//Set itself to be an AE-root-node in u.
-//Inherite u's chilren-list.
-//Do nothing if u does not have any children.
-void node::init_AE(node* u) {
-	if (u->child_num() == 0) return;
-	_children = u->_children;
-	u->clear_children();
-	for (size_t i = 0; i < _children.size(); ++i) {
-		_children[i]->set_parent(this);
+	if (at(u).AE(0) == 0) set_AE(u, 0, j);
+	else if (at(u).AE(1) == 0) set_AE(u, 1, j);
+}
+
+//Let u inherit v's artificial edge.
+void maximal_planar_subgraph_finder::inherit_AE(node_ref u, node_ref v) {
+	if (at(v).AE(0) != 0) add_AE(u, at(v).AE(0));
+	if (at(v).AE(1) != 0) add_AE(u, at(v).AE(1));
+	at(v).set_AE(0, 0);
+	at(v).set_AE(1, 0);
+}
+
+//Set u to be an AE-root-node in v.
+//Inherite v's chilren-list.
+//Do nothing if v does not have any children.
+void maximal_planar_subgraph_finder::init_AE(node_ref u, node_ref v) {
+	if (at(v).child_num() == 0) return;
+	//The list moves over with its block.
+	at(u).children() = at(v).children();
+	at(v).children().begin = at(v).children().size = 0;
+	for (int i = 0; i < at(u).child_num(); ++i) {
+		at(child(u, i)).set_parent(u);
 	}
-	set_parent(u);
-	set_1st_label(_children[0]->get_1st_label());
-	set_2nd_label(ARTIFICIAL_EDGE);
-	u->add_AE(this);
+	at(u).set_parent(v);
+	at(u).set_1st_label(at(child(u, 0)).get_1st_label());
+	at(u).set_2nd_label(ARTIFICIAL_EDGE);
+	add_AE(v, u);
 }
 
 //-----------------------------------------------------------------------------------
 // REPLICA
 //-----------------------------------------------------------------------------------
-node* node::original_node() {return _original_node;}
+node_ref node::original_node() {return _original_node;}
+
+void node::set_original_node(node_ref u) {_original_node = u;}
 
-node* node::get_c_node() {return _c_node;}
+node_ref node::get_c_node() {return _c_node;}
 
-void node::set_c_node(node* c) {_c_node = c;}
+void node::set_c_node(node_ref c) {_c_node = c;}
 
-bool node::is_sentinel() {return type() == REPLICA_NODE;} 
+bool node::is_sentinel() {return type() == REPLICA_NODE;}
 
 //Check if n1 and n2 correspond to the same node
-bool node::is_same(node* n1, node* n2) {
-	node* s1 = (n1->type() == REPLICA_NODE)? n1->original_node() : n1;
-	node* s2 = (n2->type() == REPLICA_NODE)? n2->original_node() : n2;
+bool maximal_planar_subgraph_finder::is_same(node_ref n1, node_ref n2) {
+	node_ref s1 = (at(n1).type() == REPLICA_NODE)? at(n1).original_node() : n1;
+	node_ref s2 = (at(n2).type() == REPLICA_NODE)? at(n2).original_node() : n2;
 	return s1 == s2;
 }
 
-//Set itself to be a replica-node of u in c.
+//Set u to be a replica-node of v in c.
 //Only inherit some basic setting, not including info about neighborhood.
-void node::init_replica(node* u, node* c) {
-	set_post_order_index(u->post_order_index());
-	set_2nd_label(BOUNDARY_PATH);
-	_original_node = (u->type() == REPLICA_NODE)? u->original_node() : u;
-	_c_node = c;
+void maximal_planar_subgraph_finder::init_replica(node_ref u, node_ref v, node_ref c) {
+	at(u).set_post_order_index(at(v).post_order_index());
+	at(u).set_2nd_label(BOUNDARY_PATH);
+	at(u).set_original_node((at(v).type() == REPLICA_NODE)? at(v).original_node() : v);
+	at(u).set_c_node(c);
 }
 
 //-----------------------------------------------------------------------------------
 // LABELING
 //-----------------------------------------------------------------------------------
-void node::set_1st_label(int i) {_label.first = i;}
+void node::set_1st_label(int i) {_1st_label = i;}
 
-void node::set_2nd_label(label i) {_label.second = i;}
+void node::set_2nd_label(label i) {_2nd_label = i;}
 
-int node::get_1st_label() {return _label.first;}
+int node::get_1st_label() {return _1st_label;}
 
-label node::get_2nd_label() {return _label.second;}
+label node::get_2nd_label() {return _2nd_label;}
 
 //-----------------------------------------------------------------------------------
 // C-NODE
 //-----------------------------------------------------------------------------------
-node* node::get_a_list_node() {
-	return _essential_list[0];
+node_ref maximal_planar_subgraph_finder::get_a_list_node(node_ref c) {
+	return essential(c, 0);
 }
 
 int node::c_node_size() {
-	return _essential_list.size();
+	return _essential_list.size;
+}
+
+node_ref maximal_planar_subgraph_finder::essential(node_ref c, int i) {
+	return _node_pool.list_at(at(c).essential_list(), i);
 }
 
-node* node::essential(int i) {
-	return _essential_list[i];
+void node::clear_essential() {_essential_list.size = 0;}
+
+ref_list &node::essential_list() {return _essential_list;}
+
+void maximal_planar_subgraph_finder::add_essential(node_ref c, node_ref u) {
+	_node_pool.list_push_back(at(c).essential_list(), u);
 }
 
-void node::clear_essential() {_essential_list.clear();}
 
-void node::add_essential(node* u) {_essential_list.push_back(u);}
 
 //-----------------------------------------------------------------------------------
-// MARK
+// NODE POOL
 //-----------------------------------------------------------------------------------
-void node::mark() {
-    _mark = MARKED;
-    for (auto node:_adj_list) {
-        node->_unmarked_neighbors_count--;
-    }
+//Handle 0 is taken by the null node.
+node_pool::node_pool() {
+	reset();
 }
 
-void node::un_mark() {_mark = UNMARKED;}
+node_ref node_pool::get_new_node(node_type t) {
+	if (_used == _chunks.size() * CHUNK_SIZE) {
+		_chunks.push_back(unique_ptr<node[]>(new node[CHUNK_SIZE]));
+	}
+	node_ref r = _used++;
+	(*this)[r].reinit(t);
+	return r;
+}
 
-bool node::is_marked() {return _mark == MARKED;}
+//Release every node handed out after the first keep ones, and all list blocks.
+void node_pool::reset(size_t keep) {
+	_used = 1 + keep;
+	if (_chunks.empty()) _chunks.push_back(unique_ptr<node[]>(new node[CHUNK_SIZE]));
+	_list_storage.clear();
+	for (auto &blocks:_free_blocks) blocks.clear();
+}
 
-// int node::_ref_mark = 1;
+size_t node_pool::size() {return _used - 1;}
 
-void node::add_unmarked() {
-    _unmarked_neighbors_count++;
+//Take a block of the given power-of-two capacity, return the position of its first slot.
+unsigned int node_pool::allocate_block(unsigned int capacity) {
+	int size_class = 0;
+	while ((1u << size_class) < capacity) ++size_class;
+	if (!_free_blocks[size_class].empty()) {
+		unsigned int begin = _free_blocks[size_class].back();
+		_free_blocks[size_class].pop_back();
+		return begin;
+	}
+	_list_storage.push_back(capacity);
+	unsigned int begin = _list_storage.size();
+	_list_storage.resize(_list_storage.size() + capacity);
+	return begin;
 }
 
-int node::get_unmarked_count() {
-    return _unmarked_neighbors_count;
+void node_pool::list_push_back(ref_list &l, node_ref r) {
+	unsigned int capacity = (l.begin == 0) ? 0 : _list_storage[l.begin - 1];
+	if (l.size == capacity) {
+		unsigned int begin = allocate_block(capacity == 0 ? 2 : 2 * capacity);
+		for (unsigned int i = 0; i < l.size; ++i) _list_storage[begin + i] = _list_storage[l.begin + i];
+		if (l.begin != 0) {
+			int size_class = 0;
+			while ((1u << size_class) < capacity) ++size_class;
+			_free_blocks[size_class].push_back(l.begin);
+		}
+		l.begin = begin;
+	}
+	_list_storage[l.begin + l.size++] = r;
 }
 
-
+//Remove the i-th element, the last one takes its place.
+void node_pool::list_remove(ref_list &l, int i) {
+	_list_storage[l.begin + i] = _list_storage[l.begin + l.size - 1];
+	--l.size;
+}
@@ -4,6 +4,7 @@
 
 #include <ogdf/basic/STNumbering.h>
 #include <ogdf/fileformats/GraphIO.h>
+#include "csr_ogdf.h"
 #include <ogdf/planarity/PlanarSubgraphBoyerMyrvold.h>
 #include <ogdf/planarity/MaximalPlanarSubgraphSimple.h>
 #include <filesystem>
@@ -19,7 +20,7 @@ int main(int argc, char* argv[])
     string input_file = argv[1];
     Graph G;
 
-    if (!GraphIO::read(G, input_file, GraphIO::readGML)) {
+    if (!read_graph(G, input_file)) {
         std::cerr << "Could not read input.gml" << std::endl;
         return 1;
     }
@@ -3,6 +3,7 @@
  */
 
 #include <ogdf/fileformats/GraphIO.h>
+#include "csr_ogdf.h"
 #include <ogdf/planarity/MaximumPlanarSubgraph.h>
 #include <filesystem>
 #include <iostream>
@@ -17,7 +18,7 @@ int main(int argc, char* argv[])
     string input_file = argv[1];
     Graph G;
 
-    if (!GraphIO::read(G, input_file, GraphIO::readGML)) {
+    if (!read_graph(G, input_file)) {
         std::cerr << "Could not read input.gml" << std::endl;
         return 1;
     }
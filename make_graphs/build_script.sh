@@ -7,3 +7,7 @@ echo "built make_regular_graph"
 g++ make_scale_free_graph.cpp -lOGDF -o bin/make_scale_free_graph -O3 -march=native -Wall
 
 echo "built make_scale_free_graph"
+
+g++ make_deep_graph.cpp -lOGDF -o bin/make_deep_graph -O3 -march=native -Wall
+
+echo "built make_deep_graph"
@@ -0,0 +1,47 @@
+#include <ogdf/basic/basic.h>
+#include <ogdf/basic/Graph.h>
+#include <ogdf/fileformats/GraphIO.h>
+
+using namespace ogdf;
+
+// A Hamiltonian path with chords v -> v+2 and v -> v+3 on every v, and a few random long chords.
+// Any DFS tree of it is a long path, which stresses the depth of the back-edge-traversal.
+// Every node has at least three distinct neighbors, so the solver's reduction keeps the whole
+// graph and the search runs on all of it.
+int main(int argc, char **argv) {
+    int nodeCount = std::stoi(argv[1]);
+    int longChordCount = std::stoi(argv[2]);
+    int copies = std::stoi(argv[3]);
+    int seed = std::stoi(argv[4]);
+    std::string outputFolder = argv[5];
+
+    setSeed(seed);
+    for (int i = 0; i < copies; i++) {
+        Graph G;
+        std::vector<node> nodes(nodeCount);
+        for (int v = 0; v < nodeCount; v++) {
+            nodes[v] = G.newNode();
+        }
+        for (int v = 0; v + 1 < nodeCount; v++) {
+            G.newEdge(nodes[v], nodes[v + 1]);
+        }
+        for (int v = 0; v + 2 < nodeCount; v++) {
+            G.newEdge(nodes[v], nodes[v + 2]);
+        }
+        for (int v = 0; v + 3 < nodeCount; v++) {
+            G.newEdge(nodes[v], nodes[v + 3]);
+        }
+        for (int c = 0; c < longChordCount; c++) {
+            int u = randomNumber(0, nodeCount - 1);
+            int v = randomNumber(0, nodeCount - 1);
+            if (u != v) G.newEdge(nodes[u], nodes[v]);
+        }
+
+        std::stringstream ss;
+        ss << outputFolder << "/deepn" << nodeCount << "c" << longChordCount << "s"
+        << seed << "i" << i << ".gml";
+        std::string s = ss.str();
+        GraphIO::write(G, s, GraphIO::writeGML);
+    }
+
+}